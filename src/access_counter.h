@@ -0,0 +1,164 @@
+// access_counter.h
+// Author: Ankur Roy Chowdhury
+// Read and write counters for the predictors' storage structures, for
+// energy estimates. Each structure owns an access_counter that names it and
+// gives its size. A read or write costs an energy that grows with the square
+// root of the structure's size, since its wordlines and bitlines grow that
+// way. A structure can also be given explicit per-access energies instead.
+// Counters register themselves, so the driver can print every structure's
+// accesses and energy per kilo-instruction (print_accesses). Counters with
+// the same name, e.g. the per-bit perceptrons of one engine, are summed.
+//
+// With ACCESS_COUNTERS 0 the counters are empty and every call compiles
+// away; the sweep is built that way.
+
+#ifndef ACCESS_COUNTER_H
+#define ACCESS_COUNTER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// Counting switch and energy parameters; override with
+// e.g. make CXXFLAGS="-O3 -DACCESS_COUNTERS=0"
+#ifndef ACCESS_COUNTERS
+#define ACCESS_COUNTERS 1
+#endif
+#ifndef ACCESS_ENERGY_BASE_PJ
+#define ACCESS_ENERGY_BASE_PJ 0.5	// per access, whatever the size (decoders, sense amplifiers)
+#endif
+#ifndef ACCESS_ENERGY_PJ_PER_SQRT_KB
+#define ACCESS_ENERGY_PJ_PER_SQRT_KB 1.0 // per access, times sqrt(structure size in kB)
+#endif
+#ifndef WRITE_ENERGY_FACTOR
+#define WRITE_ENERGY_FACTOR 1.2		// a write costs this many reads
+#endif
+
+// energy of one read of a structure of 'bits' bits
+inline double read_energy_pj(unsigned long long bits)
+{
+	return ACCESS_ENERGY_BASE_PJ + ACCESS_ENERGY_PJ_PER_SQRT_KB * std::sqrt(bits / 8192.0);
+}
+
+#if ACCESS_COUNTERS
+
+class access_counter
+{
+  public:
+	const char *name;
+	double read_pj, write_pj;	// energy per access
+	long long reads, writes;
+
+	// a structure of 'bits' bits, costed by its size
+	access_counter(const char *n, unsigned long long bits)
+		: name(n), read_pj(read_energy_pj(bits)), write_pj(WRITE_ENERGY_FACTOR * read_energy_pj(bits)), reads(0),
+		  writes(0)
+	{
+		registry().push_back(this);
+	}
+
+	// a structure with explicit per-access energies
+	access_counter(const char *n, double read, double write) : name(n), read_pj(read), write_pj(write), reads(0), writes(0)
+	{
+		registry().push_back(this);
+	}
+
+	access_counter(const access_counter &o) : name(o.name), read_pj(o.read_pj), write_pj(o.write_pj), reads(0), writes(0)
+	{
+		registry().push_back(this);
+	}
+
+	~access_counter(void)
+	{
+		std::vector<access_counter *> &r = registry();
+		r.erase(std::remove(r.begin(), r.end(), this), r.end());
+	}
+
+	access_counter &operator=(const access_counter &) = delete;
+
+	void read(long long n = 1)
+	{
+		reads += n;
+	}
+
+	void write(long long n = 1)
+	{
+		writes += n;
+	}
+
+	static std::vector<access_counter *> &registry(void)
+	{
+		static std::vector<access_counter *> counters;
+		return counters;
+	}
+};
+
+// every live counter's accesses and energy per kilo-instruction, summed by name
+inline void print_accesses(FILE *f, long long instructions)
+{
+	std::vector<access_counter *> &r = access_counter::registry();
+	if (r.empty() || instructions <= 0)
+		return;
+	double ki = instructions / 1000.0;
+	double total_reads = 0, total_writes = 0, total_energy = 0;
+
+	fprintf(f, "Table accesses per kilo-instruction\n");
+	fprintf(f, "  %-36s %12s %12s %12s\n", "structure", "reads/KI", "writes/KI", "pJ/KI");
+	for (size_t i = 0; i < r.size(); i++)
+	{
+		bool seen = false;
+		for (size_t j = 0; j < i; j++)
+			seen |= strcmp(r[j]->name, r[i]->name) == 0;
+		if (seen)
+			continue;
+
+		double reads = 0, writes = 0, energy = 0;
+		for (size_t j = i; j < r.size(); j++)
+		{
+			if (strcmp(r[j]->name, r[i]->name) != 0)
+				continue;
+			reads += r[j]->reads;
+			writes += r[j]->writes;
+			energy += r[j]->reads * r[j]->read_pj + r[j]->writes * r[j]->write_pj;
+		}
+		if (reads == 0 && writes == 0) // disabled or unused structure
+			continue;
+		fprintf(f, "  %-36s %12.2f %12.2f %12.2f\n", r[i]->name, reads / ki, writes / ki, energy / ki);
+		total_reads += reads;
+		total_writes += writes;
+		total_energy += energy;
+	}
+	fprintf(f, "  %-36s %12.2f %12.2f %12.2f\n", "Total", total_reads / ki, total_writes / ki, total_energy / ki);
+}
+
+#else
+
+class access_counter
+{
+  public:
+	access_counter(const char *, unsigned long long)
+	{
+	}
+
+	access_counter(const char *, double, double)
+	{
+	}
+
+	void read(long long = 1)
+	{
+	}
+
+	void write(long long = 1)
+	{
+	}
+};
+
+inline void print_accesses(FILE *, long long)
+{
+}
+
+#endif
+
+#endif
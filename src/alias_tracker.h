@@ -0,0 +1,181 @@
+// alias_tracker.h
+// Author: Ankur Roy Chowdhury
+// Aliasing analysis with shadow tags. Untagged tables (perceptron weights,
+// gshare counters, a direct-mapped BTB) and partially tagged ones (the VPC
+// BTB) let branches share entries. A shadow_tags keeps, next to each entry,
+// the full PC or virtual PC of the branch that last wrote it; the hardware
+// does not pay for these tags. Each use of an entry is then one of:
+// - compulsory: the entry has never been written;
+// - private: the last writer is the branch using it;
+// - constructive: another branch wrote it, and it points the right way;
+// - destructive: another branch wrote it, and it points the wrong way.
+// A misprediction is blamed on aliasing when the destructive entries alone
+// turned it: without their contribution it would have been correct.
+//
+// The analysis is off by default (ALIAS_ANALYSIS 0, where the classes are
+// empty and every call compiles away); make predict_alias turns it on.
+
+#ifndef ALIAS_TRACKER_H
+#define ALIAS_TRACKER_H
+
+#include <bitset>
+#include <cstdio>
+#include <cstring>
+
+#ifndef ALIAS_ANALYSIS
+#define ALIAS_ANALYSIS 0
+#endif
+
+enum alias_use
+{
+	ALIAS_COMPULSORY = 0,	// never written
+	ALIAS_PRIVATE = 1,	// last written by the same branch
+	ALIAS_CONSTRUCTIVE = 2,	// written by another branch, points the right way
+	ALIAS_DESTRUCTIVE = 3,	// written by another branch, points the wrong way
+	ALIAS_USES = 4,
+};
+
+#if ALIAS_ANALYSIS
+
+// uses by kind, and mispredictions blamed on aliasing
+class alias_stats
+{
+  public:
+	long long uses[ALIAS_USES];
+	long long mispredictions, aliased_mispredictions;
+
+	alias_stats(void) : mispredictions(0), aliased_mispredictions(0)
+	{
+		memset(uses, 0, sizeof(uses));
+	}
+
+	void count(int kind)
+	{
+		uses[kind]++;
+	}
+
+	// a prediction's outcome; 'aliased' says whether destructive aliasing turned it
+	void resolve(bool mispredicted, bool aliased)
+	{
+		mispredictions += mispredicted;
+		aliased_mispredictions += mispredicted && aliased;
+	}
+
+	void report(FILE *f, const char *name) const
+	{
+		long long total = 0;
+		for (int k = 0; k < ALIAS_USES; k++)
+			total += uses[k];
+		if (total == 0)
+			return;
+		fprintf(f, "Aliasing in %s (shadow tags)\n", name);
+		fprintf(f, "  uses                            %lld\n", total);
+		fprintf(f, "  compulsory                      %0.4f\n", uses[ALIAS_COMPULSORY] / (double)total);
+		fprintf(f, "  private                         %0.4f\n", uses[ALIAS_PRIVATE] / (double)total);
+		fprintf(f, "  constructive sharing            %0.4f\n", uses[ALIAS_CONSTRUCTIVE] / (double)total);
+		fprintf(f, "  destructive aliasing            %0.4f\n", uses[ALIAS_DESTRUCTIVE] / (double)total);
+		if (mispredictions)
+			fprintf(f, "  mispredictions from aliasing    %lld of %lld (%0.4f)\n", aliased_mispredictions,
+				mispredictions, aliased_mispredictions / (double)mispredictions);
+	}
+};
+
+// full tags of the last writer of each of N entries
+template <unsigned int N>
+class shadow_tags
+{
+  public:
+	alias_stats stats;
+
+	shadow_tags(void)
+	{
+		memset(owner, 0, sizeof(owner));
+	}
+
+	// the kind of a use of entry i by 'tag'; 'agrees' says whether the
+	// entry pointed the right way. The use is counted.
+	int use(unsigned int i, unsigned int tag, bool agrees)
+	{
+		int kind = !written[i] ? ALIAS_COMPULSORY
+			   : owner[i] == tag ? ALIAS_PRIVATE
+			   : agrees	    ? ALIAS_CONSTRUCTIVE
+					    : ALIAS_DESTRUCTIVE;
+		stats.count(kind);
+		return kind;
+	}
+
+	// whether entry i was last written by a branch other than 'tag'
+	bool shared(unsigned int i, unsigned int tag) const
+	{
+		return written[i] && owner[i] != tag;
+	}
+
+	void own(unsigned int i, unsigned int tag)
+	{
+		written[i] = true;
+		owner[i] = tag;
+	}
+
+	void resolve(bool mispredicted, bool aliased)
+	{
+		stats.resolve(mispredicted, aliased);
+	}
+
+	void report(FILE *f, const char *name) const
+	{
+		stats.report(f, name);
+	}
+
+  private:
+	unsigned int owner[N];
+	std::bitset<N> written;
+};
+
+#else
+
+class alias_stats
+{
+  public:
+	void count(int)
+	{
+	}
+
+	void resolve(bool, bool)
+	{
+	}
+
+	void report(FILE *, const char *) const
+	{
+	}
+};
+
+template <unsigned int N>
+class shadow_tags
+{
+  public:
+	int use(unsigned int, unsigned int, bool)
+	{
+		return ALIAS_PRIVATE;
+	}
+
+	bool shared(unsigned int, unsigned int) const
+	{
+		return false;
+	}
+
+	void own(unsigned int, unsigned int)
+	{
+	}
+
+	void resolve(bool, bool)
+	{
+	}
+
+	void report(FILE *, const char *) const
+	{
+	}
+};
+
+#endif
+
+#endif
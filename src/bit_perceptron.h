@@ -0,0 +1,228 @@
+// bit_perceptron.h
+// Author: Ankur Roy Chowdhury
+// Bit-level perceptron indirect target predictor. Instead of VPC's chain of
+// virtual conditional predictions, every low-order target bit is predicted
+// at once by its own perceptron (the merged path/gshare perceptron of
+// my_predictor.h, one weight matrix per bit, sharing one global history).
+// A small per-PC set of recently seen targets supplies the candidates; the
+// candidate whose bits agree best with the predicted bits, each bit weighted
+// by its perceptron's confidence, is the prediction. The latency is one
+// round of parallel perceptron lookups whatever the number of targets.
+
+#ifndef BIT_PERCEPTRON_H
+#define BIT_PERCEPTRON_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "budget.h"
+
+template <class P_, int TARGET_BITS_, int TARGET_SHIFT_, int CANDIDATES_, int LOG_SETS_, int TAG_BITS_>
+struct bit_perceptron_params
+{
+	typedef P_ P;					// perceptron parameters (vpc_params; only H, NUM_WTS, MASK_BITS, WEIGHT_BITS and THETA are used)
+	static const int TARGET_BITS = TARGET_BITS_;	// target bits predicted, one perceptron each
+	static const int TARGET_SHIFT = TARGET_SHIFT_;	// lowest target bit predicted
+	static const int CANDIDATES = CANDIDATES_;	// candidate targets kept per branch
+	static const int LOG_SETS = LOG_SETS_;		// log2 of candidate sets
+	static const int TAG_BITS = TAG_BITS_;		// candidate set partial tag width
+
+	static_assert(TARGET_BITS_ >= 1 && TARGET_SHIFT_ + TARGET_BITS_ <= 32, "predicted bits must lie within the target");
+	static_assert(CANDIDATES_ >= 1 && CANDIDATES_ <= 16, "1 to 16 candidates per branch");
+};
+
+typedef bit_perceptron_params<
+	vpc_params<6, 512, 10, 25, 1024, 4, 20, 1640, 8, 7, 8, 64, 4, 65536, true, THETA_ADAPTIVE,
+		   0>,	// 7 x 512 8-bit weights per target bit; no bias filter
+	12,	// TARGET_BITS
+	0,	// TARGET_SHIFT
+	8,	// CANDIDATES
+	10,	// LOG_SETS: 1024 candidate sets
+	10>	// TAG_BITS
+	bit_perceptron_config;
+
+template <class C>
+class bit_perceptron_update : public branch_update
+{
+  public:
+	typename merged_perceptron<typename C::P>::info_type bits[C::TARGET_BITS]; // per-bit perceptron state
+	int set;		// candidate set, -1 if the branch had none
+	int chosen;		// candidate predicted, -1 for none
+
+	bit_perceptron_update(void) : set(-1), chosen(-1) {}
+};
+
+template <class C>
+class bit_perceptron_predictor : public branch_predictor
+{
+  public:
+	typedef typename C::P P;
+	typedef merged_perceptron<P> perceptron;
+
+	static const int TARGET_BITS = C::TARGET_BITS;
+	static const int TARGET_SHIFT = C::TARGET_SHIFT;
+	static const int CANDIDATES = C::CANDIDATES;
+	static const int SETS = 1 << C::LOG_SETS;
+	static const int TAG_BITS = C::TAG_BITS;
+
+	struct candidate_set
+	{
+		bool valid;
+		unsigned int tag;
+		unsigned int target[CANDIDATES];	// 0: empty slot
+		unsigned char age[CANDIDATES];		// LRU age, 0 = most recent
+	};
+
+	bit_perceptron_update<C> u;
+	branch_info bi;
+
+	// bit[0] also owns the global history every bit predicts with
+	perceptron bit[TARGET_BITS];
+	candidate_set sets[SETS];
+
+	long long predictions, no_candidates, target_absent, correct;
+
+	static constexpr budget_component BUDGET[] = {
+		{"GHR", 1, P::HIST_LEN},
+		{"Path register", 1, P::HIST_LEN},
+		{"Per-bit weight tables", (unsigned long long)TARGET_BITS * (P::H + 1) * P::NUM_WTS, P::WEIGHT_BITS},
+		{"Candidate sets (valid + tag)", SETS, 1 + TAG_BITS},
+		{"Candidate targets (target + age)", (unsigned long long)SETS * CANDIDATES, 32 + bits_for(CANDIDATES)},
+	};
+	static_assert(budget_bits(BUDGET) <= BUDGET_LIMIT_BITS, "bit_perceptron_predictor exceeds BUDGET_LIMIT_KB");
+
+	bit_perceptron_predictor(void) : predictions(0), no_candidates(0), target_absent(0), correct(0)
+	{
+		memset(sets, 0, sizeof(sets));
+	}
+
+	void print_budget(FILE *f)
+	{
+		::print_budget(f, "Bit-level perceptron", BUDGET);
+	}
+
+	void report(FILE *f, bool)
+	{
+		fprintf(f, "Bit-level perceptron statistics\n");
+		fprintf(f, "  indirect predictions            %lld\n", predictions);
+		fprintf(f, "  perceptron lookups per pred.    %d (one parallel round)\n", TARGET_BITS);
+		if (predictions == 0)
+			return;
+		fprintf(f, "  no candidates                   %0.4f\n", no_candidates / (double)predictions);
+		fprintf(f, "  target not among candidates     %0.4f\n", target_absent / (double)predictions);
+		fprintf(f, "  correct                         %0.4f\n", correct / (double)predictions);
+	}
+
+	branch_update *predict(branch_info &b)
+	{
+		bi = b;
+		u.set = -1;
+		u.chosen = -1;
+		u.direction_prediction(true);
+		u.target_prediction(0);
+
+		if (!(b.br_flags & BR_INDIRECT))
+			return &u;
+
+		int output[TARGET_BITS];
+		for (int i = 0; i < TARGET_BITS; i++)
+		{
+			bit[i].predict(b.address, bit[0].history(), u.bits[i]);
+			output[i] = u.bits[i].perceptron_output;
+		}
+
+		candidate_set &s = sets[set_index(b.address)];
+		if (!s.valid || s.tag != tag(b.address))
+			return &u;
+		u.set = set_index(b.address);
+
+		// agreement with the predicted bits, each weighted by its confidence
+		int best = 0;
+		for (int c = 0; c < CANDIDATES; c++)
+		{
+			if (s.target[c] == 0)
+				continue;
+			int score = 0;
+			for (int i = 0; i < TARGET_BITS; i++)
+				score += ((s.target[c] >> (TARGET_SHIFT + i)) & 1) ? output[i] : -output[i];
+			if (u.chosen < 0 || score > best)
+			{
+				u.chosen = c;
+				best = score;
+			}
+		}
+		if (u.chosen >= 0)
+			u.target_prediction(s.target[u.chosen]);
+		return &u;
+	}
+
+	void update(branch_update *bu, bool taken, unsigned int target)
+	{
+		bit_perceptron_update<C> *mu = (bit_perceptron_update<C> *)bu;
+
+		if (bi.br_flags & BR_INDIRECT)
+		{
+			predictions++;
+			no_candidates += mu->chosen < 0;
+			correct += mu->target_prediction() == target;
+
+			for (int i = 0; i < TARGET_BITS; i++)
+				bit[i].train(mu->bits[i], (target >> (TARGET_SHIFT + i)) & 1);
+
+			if (!insert(bi.address, target) && mu->chosen >= 0)
+				target_absent++;
+		}
+
+		// conditional outcomes, and one target bit per indirect branch
+		if (bi.br_flags & BR_CONDITIONAL)
+			bit[0].update_history(bi.address, taken);
+		if (bi.br_flags & BR_INDIRECT)
+			bit[0].update_history(bi.address, (target >> (TARGET_SHIFT + 2)) & 1);
+	}
+
+  private:
+	static unsigned int set_index(unsigned int pc)
+	{
+		return pc & (SETS - 1);
+	}
+
+	static unsigned int tag(unsigned int pc)
+	{
+		return (pc >> C::LOG_SETS) & ((1u << TAG_BITS) - 1);
+	}
+
+	// make target the most recent candidate of pc, replacing the LRU one if
+	// needed; returns whether it was already a candidate
+	bool insert(unsigned int pc, unsigned int target)
+	{
+		candidate_set &s = sets[set_index(pc)];
+		if (!s.valid || s.tag != tag(pc))
+		{
+			memset(&s, 0, sizeof(s));
+			s.valid = true;
+			s.tag = tag(pc);
+			for (int c = 0; c < CANDIDATES; c++)
+				s.age[c] = c;
+		}
+
+		int slot = -1;
+		for (int c = 0; c < CANDIDATES; c++)
+			if (s.target[c] == target)
+				slot = c;
+		bool found = slot >= 0;
+		if (!found)
+			for (int c = 0; c < CANDIDATES; c++)
+				if (s.age[c] == CANDIDATES - 1)
+					slot = c;
+
+		for (int c = 0; c < CANDIDATES; c++)
+			if (s.age[c] < s.age[slot])
+				s.age[c]++;
+		s.age[slot] = 0;
+		s.target[slot] = target;
+		return found;
+	}
+};
+
+#endif
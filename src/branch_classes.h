@@ -0,0 +1,109 @@
+// branch_classes.h
+// Author: Ankur Roy Chowdhury
+// The driver's misprediction breakdown by branch class: conditional branches
+// by opcode, indirect jumps and indirect calls separately, and returns as
+// predicted by a return address stack model (return_stack.h) of RAS_DEPTH
+// entries. Each class reports its branches, mispredictions, miss rate and
+// its share of the MPKI. Conditional and indirect rows add up to the
+// direction and indirect MPKI the driver prints; the simulated predictors do
+// not predict returns, so the return row is the RAS model's alone.
+
+#ifndef BRANCH_CLASSES_H
+#define BRANCH_CLASSES_H
+
+#include <cstdio>
+#include <cstring>
+
+#include "return_stack.h"
+
+// entries of the return address stack model; 0 leaves returns out
+#ifndef RAS_DEPTH
+#define RAS_DEPTH 16
+#endif
+
+class branch_class_stats
+{
+  public:
+	enum branch_class
+	{
+		INDIRECT_JUMP = 16,	// classes 0 to 15 are the conditional opcodes
+		INDIRECT_CALL = 17,
+		RETURN = 18,
+		CLASSES = 19,
+	};
+
+	long long branches[CLASSES], misses[CLASSES];
+
+	branch_class_stats(void)
+	{
+		memset(branches, 0, sizeof(branches));
+		memset(misses, 0, sizeof(misses));
+	}
+
+	// a branch with its outcome and the predictor's prediction
+	void record(const branch_info &bi, bool taken, unsigned int target, branch_update *u)
+	{
+		if (bi.br_flags & BR_CONDITIONAL)
+			count(bi.opcode & 15, u->direction_prediction() != taken);
+		if (bi.br_flags & BR_INDIRECT)
+			count((bi.br_flags & BR_CALL) ? INDIRECT_CALL : INDIRECT_JUMP, u->target_prediction() != target);
+		if (RAS_DEPTH && (bi.br_flags & BR_CALL))
+			ras.call(bi.address);
+		if (RAS_DEPTH && (bi.br_flags & BR_RETURN))
+			count(RETURN, !ras.ret(target));
+	}
+
+	void report(FILE *f, long long instructions) const
+	{
+		if (instructions <= 0)
+			return;
+		fprintf(f, "Mispredictions by branch class\n");
+		fprintf(f, "  %-20s %12s %12s %10s %8s\n", "class", "branches", "misses", "miss rate", "MPKI");
+		long long b = 0, m = 0;
+		for (int c = 0; c < 16; c++)
+		{
+			char label[32];
+			snprintf(label, sizeof(label), "conditional %s", opcode_name(c));
+			row(f, label, branches[c], misses[c], instructions);
+			b += branches[c];
+			m += misses[c];
+		}
+		row(f, "conditional total", b, m, instructions);
+		row(f, "indirect jump", branches[INDIRECT_JUMP], misses[INDIRECT_JUMP], instructions);
+		row(f, "indirect call", branches[INDIRECT_CALL], misses[INDIRECT_CALL], instructions);
+		row(f, "indirect total", branches[INDIRECT_JUMP] + branches[INDIRECT_CALL],
+		    misses[INDIRECT_JUMP] + misses[INDIRECT_CALL], instructions);
+		if (RAS_DEPTH)
+		{
+			char label[32];
+			snprintf(label, sizeof(label), "return (%d-entry RAS)", RAS_DEPTH);
+			row(f, label, branches[RETURN], misses[RETURN], instructions);
+		}
+	}
+
+  private:
+	return_stack<RAS_DEPTH ? RAS_DEPTH : 1> ras;
+
+	void count(int c, bool miss)
+	{
+		branches[c]++;
+		misses[c] += miss;
+	}
+
+	static void row(FILE *f, const char *label, long long n, long long m, long long instructions)
+	{
+		if (n == 0)
+			return;
+		fprintf(f, "  %-20s %12lld %12lld %10.4f %8.3f\n", label, n, m, m / (double)n, 1000.0 * m / instructions);
+	}
+
+	// JO also stands for JCXZ/JECXZ, which the traces alias to it
+	static const char *opcode_name(int op)
+	{
+		static const char *const names[16] = {"jo", "jno", "jc", "jnc", "jz", "jnz", "jbe", "ja",
+						      "js", "jns", "jp", "jnp", "jl", "jge", "jle", "jg"};
+		return names[op];
+	}
+};
+
+#endif
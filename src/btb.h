@@ -0,0 +1,200 @@
+// btb.h
+// Author: Ankur Roy Chowdhury
+// Set-associative, partially tagged BTB used by the VPC predictor.
+// Each set keeps true-LRU ages as its replacement metadata. It is a single
+// level answering every lookup in LATENCY cycles; btb_hierarchy.h builds a
+// two-level BTB out of two of them.
+
+#ifndef BTB_H
+#define BTB_H
+
+#include <cstdio>
+#include <cstring>
+
+#include "access_counter.h"
+#include "alias_tracker.h"
+#include "budget.h"
+
+template <unsigned int SETS, unsigned int WAYS, unsigned int TAG_BITS, int LATENCY = 1>
+class vpc_btb
+{
+  public:
+	static const int LEVELS = 1;
+	static const int MAX_LATENCY = LATENCY;
+	static const unsigned int ENTRIES = SETS * WAYS;
+	static const unsigned int TAG_MASK = (1u << TAG_BITS) - 1;
+
+	static const unsigned int INDEX_BITS = bits_for(SETS);
+	static const unsigned int LRU_BITS = bits_for(WAYS);
+	static const unsigned int ENTRY_BITS = 1 + TAG_BITS + 32; // valid + tag + target
+
+	static_assert((SETS & (SETS - 1)) == 0, "BTB set count must be a power of two");
+	static_assert(TAG_BITS > 0 && TAG_BITS < 32, "BTB tag must be between 1 and 31 bits");
+	static_assert(WAYS <= 256, "BTB LRU ages are stored in an unsigned char");
+
+	static constexpr budget_component BUDGET[] = {
+		{"BTB entries (valid + tag + target)", ENTRIES, ENTRY_BITS},
+		{"BTB LRU ages", ENTRIES, LRU_BITS},
+	};
+
+	struct entry
+	{
+		bool valid;		// replaces the old 'target == 0' invalid marker
+		unsigned int tag;	// partial tag
+		unsigned int target;	// full branch target
+	};
+
+	entry sets[SETS][WAYS];
+	unsigned char lru[SETS][WAYS]; // per-set replacement metadata; 0 is the most recently used way
+	mutable access_counter accesses;
+	shadow_tags<ENTRIES> shadow;	// full virtual PC of each entry (ALIAS_ANALYSIS)
+
+	explicit vpc_btb(const char *name = "BTB") : accesses(name, ENTRIES * (ENTRY_BITS + LRU_BITS))
+	{
+		memset(sets, 0, sizeof(sets));
+		for (unsigned int s = 0; s < SETS; s++)
+			for (unsigned int w = 0; w < WAYS; w++)
+				lru[s][w] = w;
+	}
+
+	unsigned int set_index(unsigned int vpca) const
+	{
+		return vpca & (SETS - 1);
+	}
+
+	// the bits above the index are folded down into TAG_BITS
+	unsigned int tag(unsigned int vpca) const
+	{
+		unsigned int t = 0;
+		for (unsigned int rest = vpca >> INDEX_BITS; rest; rest >>= TAG_BITS)
+			t ^= rest & TAG_MASK;
+		return t;
+	}
+
+	// returns the way holding vpca, or -1 if it is not present
+	int find(unsigned int vpca) const
+	{
+		const entry *set = sets[set_index(vpca)];
+		unsigned int t = tag(vpca);
+		for (unsigned int w = 0; w < WAYS; w++)
+		{
+			if (set[w].valid && set[w].tag == t)
+				return w;
+		}
+		return -1;
+	}
+
+	// prediction-time lookup; does not disturb the replacement state
+	bool lookup(unsigned int vpca, unsigned int &target) const
+	{
+		accesses.read();
+		int w = find(vpca);
+		if (w < 0)
+			return false;
+		target = sets[set_index(vpca)][w].target;
+		return true;
+	}
+
+	// whether vpca hits an entry written for another virtual PC whose
+	// partial tag matches; always false without ALIAS_ANALYSIS
+	bool aliased(unsigned int vpca) const
+	{
+		int w = find(vpca);
+		return w >= 0 && shadow.shared(set_index(vpca) * WAYS + w, vpca);
+	}
+
+	// lookup() that also says which level served it: 0, or -1 for a miss
+	int lookup_level(unsigned int vpca, unsigned int &target) const
+	{
+		return lookup(vpca, target) ? 0 : -1;
+	}
+
+	// cycles of a lookup served by 'level' (-1: a miss)
+	static int latency(int)
+	{
+		return LATENCY;
+	}
+
+	// mark the entry holding vpca as most recently used
+	void touch(unsigned int vpca)
+	{
+		int w = find(vpca);
+		if (w >= 0)
+		{
+			accesses.write();
+			promote(set_index(vpca), w);
+		}
+	}
+
+	// the way insert() would write vpca to: its own, else an invalid one,
+	// else the LRU one
+	int victim(unsigned int vpca) const
+	{
+		unsigned int s = set_index(vpca);
+		int w = find(vpca);
+		if (w >= 0)
+			return w;
+		w = 0;
+		for (unsigned int i = 0; i < WAYS; i++)
+		{
+			if (!sets[s][i].valid)
+				return i;
+			if (lru[s][i] > lru[s][w])
+				w = i;
+		}
+		return w;
+	}
+
+	// install (or overwrite) the target for vpca, evicting the LRU way if needed
+	void insert(unsigned int vpca, unsigned int target)
+	{
+		unsigned int s = set_index(vpca);
+		int w = victim(vpca);
+		accesses.write();
+		sets[s][w].valid = true;
+		sets[s][w].tag = tag(vpca);
+		sets[s][w].target = target;
+		shadow.own(s * WAYS + w, vpca);
+		promote(s, w);
+	}
+
+	// drop vpca if present; its way becomes the first to be reused
+	void invalidate(unsigned int vpca)
+	{
+		int w = find(vpca);
+		if (w >= 0)
+		{
+			accesses.write();
+			sets[set_index(vpca)][w].valid = false;
+		}
+	}
+
+	// a single level moves no entries
+	void report(FILE *) const
+	{
+	}
+
+	// number of valid entries
+	unsigned int occupancy(void) const
+	{
+		unsigned int count = 0;
+		for (unsigned int s = 0; s < SETS; s++)
+			for (unsigned int w = 0; w < WAYS; w++)
+				count += sets[s][w].valid;
+		return count;
+	}
+
+  private:
+	void promote(unsigned int s, unsigned int w)
+	{
+		unsigned char age = lru[s][w];
+		for (unsigned int i = 0; i < WAYS; i++)
+		{
+			if (lru[s][i] < age)
+				lru[s][i]++;
+		}
+		lru[s][w] = 0;
+	}
+};
+
+#endif
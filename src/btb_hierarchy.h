@@ -0,0 +1,172 @@
+// btb_hierarchy.h
+// Author: Ankur Roy Chowdhury
+// Two-level BTB for the VPC predictor: a small L1 answers in L1_LATENCY
+// cycles, and a larger L2 behind it in L2_LATENCY cycles. A lookup that
+// misses both levels costs the L2 latency, since only the L2 can say so.
+// Prediction-time lookups do not move entries; when a target is used
+// (touch) or written (insert), it goes to the L1.
+//
+// Two policies move entries between the levels:
+// - BTB_EXCLUSIVE: an entry lives in one level. Using an L2 entry promotes
+//   it to the L1, and the L1 entry it replaces is demoted to the L2. The L1
+//   keeps each entry's virtual PC so a demoted entry can be re-indexed.
+// - BTB_FILL_BOTH: new targets are written to both levels, and a used L2
+//   entry is copied into the L1. L1 victims are dropped, since the L2 most
+//   likely still holds them.
+
+#ifndef BTB_HIERARCHY_H
+#define BTB_HIERARCHY_H
+
+#include <cstdio>
+#include <cstring>
+
+#include "btb.h"
+#include "budget.h"
+
+// how entries move between the BTB levels
+enum btb_policy
+{
+	BTB_EXCLUSIVE = 0,	// each entry in one level; L1 victims are demoted to the L2
+	BTB_FILL_BOTH = 1,	// new targets go to both levels; L1 victims are dropped
+};
+
+template <unsigned int L1_SETS, unsigned int L1_WAYS, unsigned int L2_SETS, unsigned int L2_WAYS, unsigned int TAG_BITS,
+	  int L1_LATENCY = 1, int L2_LATENCY = 3, int POLICY = BTB_EXCLUSIVE>
+class two_level_btb
+{
+  public:
+	typedef vpc_btb<L2_SETS, L2_WAYS, TAG_BITS, L2_LATENCY> l2_type;
+	// the L1 tag also keeps the index bits the L2 has and the L1 lacks, so
+	// the small L1 aliases no more than the L2
+	static const unsigned int L1_TAG_BITS = TAG_BITS + (L2_SETS > L1_SETS ? bits_for(L2_SETS) - bits_for(L1_SETS) : 0);
+	typedef vpc_btb<L1_SETS, L1_WAYS, L1_TAG_BITS, L1_LATENCY> l1_type;
+
+	static const int LEVELS = 2;
+	static const int MAX_LATENCY = L2_LATENCY;
+	static const unsigned int ENTRIES = l1_type::ENTRIES + l2_type::ENTRIES;
+
+	// an L1 entry's index and tag do not give back its virtual PC
+	static const unsigned int ADDRESS_BITS = POLICY == BTB_EXCLUSIVE ? 32 - l1_type::INDEX_BITS : 0;
+
+	static_assert(POLICY == BTB_EXCLUSIVE || POLICY == BTB_FILL_BOTH, "POLICY is a btb_policy");
+	static_assert(L1_LATENCY >= 1 && L1_LATENCY <= L2_LATENCY, "the L1 is the faster level");
+
+	static constexpr budget_component BUDGET[] = {
+		{"L1 BTB entries (valid + tag + target)", l1_type::ENTRIES, l1_type::ENTRY_BITS},
+		{"L1 BTB LRU ages", l1_type::ENTRIES, l1_type::LRU_BITS},
+		{"L1 BTB virtual PCs (for demotion)", ADDRESS_BITS ? l1_type::ENTRIES : 0, ADDRESS_BITS},
+		{"L2 BTB entries (valid + tag + target)", l2_type::ENTRIES, l2_type::ENTRY_BITS},
+		{"L2 BTB LRU ages", l2_type::ENTRIES, l2_type::LRU_BITS},
+	};
+
+	l1_type l1;
+	l2_type l2;
+	unsigned int address[L1_SETS][L1_WAYS];	// virtual PC of each L1 entry
+
+	long long promotions, demotions;
+
+	two_level_btb(void) : l1("L1 BTB"), l2("L2 BTB"), promotions(0), demotions(0)
+	{
+		memset(address, 0, sizeof(address));
+	}
+
+	// prediction-time lookup; does not disturb either level
+	bool lookup(unsigned int vpca, unsigned int &target) const
+	{
+		return lookup_level(vpca, target) >= 0;
+	}
+
+	// lookup() that also says which level served it: 0 or 1, or -1 for a miss
+	int lookup_level(unsigned int vpca, unsigned int &target) const
+	{
+		if (l1.lookup(vpca, target))
+			return 0;
+		if (l2.lookup(vpca, target))
+			return 1;
+		return -1;
+	}
+
+	// whether the entry vpca hits belongs to another virtual PC
+	bool aliased(unsigned int vpca) const
+	{
+		return l1.find(vpca) >= 0 ? l1.aliased(vpca) : l2.aliased(vpca);
+	}
+
+	static int latency(int level)
+	{
+		return level == 0 ? L1_LATENCY : L2_LATENCY;
+	}
+
+	// vpca's target was used; an L2 entry is promoted to the L1
+	void touch(unsigned int vpca)
+	{
+		unsigned int target;
+		if (l1.find(vpca) >= 0)
+		{
+			l1.touch(vpca);
+			if (POLICY == BTB_FILL_BOTH)
+				l2.touch(vpca);
+		}
+		else if (l2.lookup(vpca, target))
+		{
+			promotions++;
+			if (POLICY == BTB_EXCLUSIVE)
+				l2.invalidate(vpca);
+			else
+				l2.touch(vpca);
+			fill(vpca, target);
+		}
+	}
+
+	void insert(unsigned int vpca, unsigned int target)
+	{
+		if (POLICY == BTB_EXCLUSIVE)
+			l2.invalidate(vpca);
+		else
+			l2.insert(vpca, target);
+		fill(vpca, target);
+	}
+
+	void report(FILE *f) const
+	{
+		fprintf(f, "Two-level BTB statistics\n");
+		fprintf(f, "  promotions to L1                %lld\n", promotions);
+		if (POLICY == BTB_EXCLUSIVE)
+			fprintf(f, "  demotions to L2                 %lld\n", demotions);
+		fprintf(f, "  occupancy                       L1 %u/%u, L2 %u/%u\n", l1.occupancy(), l1_type::ENTRIES,
+			l2.occupancy(), l2_type::ENTRIES);
+	}
+
+	unsigned int occupancy(void) const
+	{
+		return l1.occupancy() + l2.occupancy();
+	}
+
+  private:
+	// write vpca to the L1, demoting the entry it replaces if EXCLUSIVE
+	void fill(unsigned int vpca, unsigned int target)
+	{
+		unsigned int s = l1.set_index(vpca);
+		int w = l1.victim(vpca);
+		typename l1_type::entry old = l1.sets[s][w];
+		bool evicts = old.valid && l1.find(vpca) < 0;
+
+		l1.insert(vpca, target);
+		if (POLICY == BTB_EXCLUSIVE && evicts)
+		{
+			demotions++;
+			l2.insert(address[s][w], old.target);
+		}
+		address[s][w] = vpca;
+	}
+};
+
+// the VPC BTB's 4K entries behind a 256-entry L1
+typedef two_level_btb<64, 4,	// L1: 64 sets x 4 ways
+		      1024, 4,	// L2: 1024 sets x 4 ways
+		      8,	// L2 partial tag bits, as in vpc_config; the L1 gets 12
+		      1, 3,	// L1 and L2 latency in cycles
+		      BTB_EXCLUSIVE>
+	vpc_two_level_btb;
+
+#endif
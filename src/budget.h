@@ -0,0 +1,75 @@
+// budget.h
+// Author: Ankur Roy Chowdhury
+// Compile-time storage budget accounting. Every predictor lists its state as
+// an array of budget_component; the total is computed by the compiler and
+// checked against BUDGET_LIMIT_KB, and print_budget() itemizes it at runtime.
+
+#ifndef BUDGET_H
+#define BUDGET_H
+
+#include <cstdio>
+
+// Storage limit enforced on every predictor; override with
+// e.g. make CXXFLAGS="-O3 -DBUDGET_LIMIT_KB=64"
+#ifndef BUDGET_LIMIT_KB
+#define BUDGET_LIMIT_KB 1024
+#endif
+#define BUDGET_LIMIT_BITS (BUDGET_LIMIT_KB * 8192ull)
+
+// number of bits needed to hold a value in [0, n)
+constexpr unsigned int bits_for(unsigned long long n)
+{
+	return (n <= 1) ? 0 : 1 + bits_for((n + 1) >> 1);
+}
+
+struct budget_component
+{
+	const char *name;
+	unsigned long long entries;	// number of entries
+	unsigned long long bits;	// bits per entry
+
+	constexpr unsigned long long total(void) const { return entries * bits; }
+};
+
+// total storage in bits of a component list
+template <unsigned int N>
+constexpr unsigned long long budget_bits(const budget_component (&c)[N], unsigned int i = 0)
+{
+	return (i == N) ? 0 : c[i].total() + budget_bits(c, i + 1);
+}
+
+template <unsigned int N>
+void print_budget(FILE *f, const char *name, const budget_component (&c)[N])
+{
+	fprintf(f, "Storage budget: %s\n", name);
+	for (unsigned int i = 0; i < N; i++)
+		fprintf(f, "  %-36s %10llu x %3llu bits = %10llu bits\n", c[i].name, c[i].entries, c[i].bits, c[i].total());
+
+	unsigned long long total = budget_bits(c);
+	fprintf(f, "  %-36s %34llu bits (%llu B, %0.2f kB; limit %u kB)\n", "Total", total,
+		(total + 7) / 8, total / 8192.0, (unsigned int)BUDGET_LIMIT_KB);
+}
+
+// total storage in bits of a predictor P: its TOTAL_BUDGET_BITS when it is
+// built from several parts, else its own BUDGET; call with an int argument
+template <class P>
+constexpr auto predictor_budget_bits(int) -> decltype(P::TOTAL_BUDGET_BITS + 0)
+{
+	return P::TOTAL_BUDGET_BITS;
+}
+
+template <class P>
+constexpr unsigned long long predictor_budget_bits(long)
+{
+	return budget_bits(P::BUDGET);
+}
+
+// the closing line of a predictor built from several parts; a wrapper names
+// itself so its line reads apart from the total its inner predictor prints
+inline void print_budget_total(FILE *f, unsigned long long total, const char *wrapper = 0)
+{
+	fprintf(f, "Storage budget total%s%s%s: %llu bits (%0.2f kB; limit %u kB)\n", wrapper ? " (" : "",
+		wrapper ? wrapper : "", wrapper ? ")" : "", total, total / 8192.0, (unsigned int)BUDGET_LIMIT_KB);
+}
+
+#endif
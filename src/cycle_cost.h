@@ -0,0 +1,105 @@
+// cycle_cost.h
+// Author: Ankur Roy Chowdhury
+// Cycle-cost model of a prediction. A direction component costs its serial
+// table reads plus the depth of the adder tree that sums what it read, and
+// declares the result as LOOKUP_CYCLES. A VPC iteration reads the BTB and
+// the direction component in parallel. The iterations run one after the
+// other, so an indirect prediction costs the sum of its iterations.
+// latency_stats keeps the distribution of these costs.
+//
+// A prediction that takes one cycle keeps fetch going; every further cycle
+// is a front-end bubble. The front-end cost of a configuration is its
+// bubbles plus MISPREDICT_PENALTY_CYCLES per misprediction.
+
+#ifndef CYCLE_COST_H
+#define CYCLE_COST_H
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "budget.h"
+
+// Cost parameters; override with e.g. make CXXFLAGS="-O3 -DTABLE_READ_CYCLES=2"
+#ifndef TABLE_READ_CYCLES
+#define TABLE_READ_CYCLES 1		// one predictor table read
+#endif
+#ifndef ADDER_LEVELS_PER_CYCLE
+#define ADDER_LEVELS_PER_CYCLE 3	// levels of a (carry-save) adder tree done per cycle
+#endif
+#ifndef MISPREDICT_PENALTY_CYCLES
+#define MISPREDICT_PENALTY_CYCLES 20	// front-end refill after a misprediction
+#endif
+
+// cycles to sum 'inputs' values with a binary adder tree
+constexpr int adder_cycles(int inputs)
+{
+	return ((int)bits_for(inputs) + ADDER_LEVELS_PER_CYCLE - 1) / ADDER_LEVELS_PER_CYCLE;
+}
+
+// cycles of 'reads' serial table reads whose results are summed by an
+// adder tree of 'adder_inputs' inputs
+constexpr int lookup_cycles(int reads, int adder_inputs)
+{
+	return reads * TABLE_READ_CYCLES + adder_cycles(adder_inputs);
+}
+
+template <int MAX_CYCLES>
+class latency_stats
+{
+  public:
+	long long predictions, cycles;
+	long long hist[MAX_CYCLES + 1];	// predictions by cycles, clamped to MAX_CYCLES
+
+	latency_stats(void) : predictions(0), cycles(0)
+	{
+		memset(hist, 0, sizeof(hist));
+	}
+
+	void record(int c)
+	{
+		predictions++;
+		cycles += c;
+		hist[std::min(c, MAX_CYCLES)]++;
+	}
+
+	void add(const latency_stats &o)
+	{
+		predictions += o.predictions;
+		cycles += o.cycles;
+		for (int i = 0; i <= MAX_CYCLES; i++)
+			hist[i] += o.hist[i];
+	}
+
+	// cycles beyond the first, summed over the predictions
+	long long bubbles(void) const
+	{
+		return cycles - (predictions - hist[0]);
+	}
+
+	// smallest c such that at least q of the predictions took c cycles or fewer
+	int percentile(double q) const
+	{
+		long long seen = 0;
+		for (int i = 0; i <= MAX_CYCLES; i++)
+		{
+			seen += hist[i];
+			if (seen >= q * predictions)
+				return i;
+		}
+		return MAX_CYCLES;
+	}
+
+	void print(FILE *f, const char *label) const
+	{
+		if (predictions == 0)
+			return;
+		int max = MAX_CYCLES;
+		while (max > 0 && hist[max] == 0)
+			max--;
+		fprintf(f, "  %-31s avg %0.3f, P50 %d, P90 %d, P99 %d, max %d\n", label, cycles / (double)predictions,
+			percentile(0.5), percentile(0.9), percentile(0.99), max);
+	}
+};
+
+#endif
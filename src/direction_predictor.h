@@ -0,0 +1,76 @@
+// direction_predictor.h
+// Author: Ankur Roy Chowdhury
+// Stand-alone branch_predictor around a direction component (the interface
+// vpc_predictor uses, see my_predictor.h). Conditional branches go to the
+// component; indirect branches get the last target seen, from a simple
+// direct-mapped table like the one in the gshare sample. With TARGET_BITS 0
+// there is no target table, for pairing with a separate indirect engine in
+// split_predictor.
+
+#ifndef DIRECTION_PREDICTOR_H
+#define DIRECTION_PREDICTOR_H
+
+#include <cstdio>
+#include <cstring>
+
+#include "budget.h"
+
+template <class D, int TARGET_BITS = 12>
+class direction_predictor : public branch_predictor
+{
+  public:
+	branch_update u;
+	branch_info bi;
+
+	D dir;
+	typename D::info_type info;
+	unsigned int targets[1 << TARGET_BITS];
+
+	static constexpr budget_component BUDGET[] = {
+		{"Last-target table", TARGET_BITS ? 1 << TARGET_BITS : 0, 32},
+	};
+	static constexpr unsigned long long TOTAL_BUDGET_BITS = budget_bits(D::BUDGET) + budget_bits(BUDGET);
+	static_assert(TOTAL_BUDGET_BITS <= BUDGET_LIMIT_BITS, "direction_predictor exceeds BUDGET_LIMIT_KB");
+
+	direction_predictor(void) : info()
+	{
+		memset(targets, 0, sizeof(targets));
+	}
+
+	void print_budget(FILE *f)
+	{
+		::print_budget(f, D::NAME, D::BUDGET);
+		if (TARGET_BITS)
+			::print_budget(f, "indirect targets", BUDGET);
+	}
+
+	void report(FILE *f, bool detailed)
+	{
+		dir.report(f, detailed);
+	}
+
+	branch_update *predict(branch_info &b)
+	{
+		bi = b;
+		if (b.br_flags & BR_CONDITIONAL)
+			u.direction_prediction(dir.predict(b.address, dir.history(), info));
+		else
+			u.direction_prediction(true);
+		if (TARGET_BITS && (b.br_flags & BR_INDIRECT))
+			u.target_prediction(targets[b.address & ((1 << TARGET_BITS) - 1)]);
+		return &u;
+	}
+
+	void update(branch_update *, bool taken, unsigned int target)
+	{
+		if (bi.br_flags & BR_CONDITIONAL)
+		{
+			dir.train(info, taken);
+			dir.update_history(bi.address, taken);
+		}
+		if (TARGET_BITS && (bi.br_flags & BR_INDIRECT))
+			targets[bi.address & ((1 << TARGET_BITS) - 1)] = target;
+	}
+};
+
+#endif
@@ -0,0 +1,147 @@
+// folded_history.h
+// Author: Ankur Roy Chowdhury
+// Long global history: a circular buffer of history bits, packed 64 to a
+// word, plus folded (compressed) copies of its most recent bits that are
+// maintained incrementally, one shift and two XORs per pushed bit. History
+// lengths are limited only by the buffer size, not by a machine word: a
+// push is O(1) and any window of up to 32 bits reads in O(1). The
+// perceptrons, which read a fixed set of history segments, keep them in a
+// segmented_history instead.
+
+#ifndef FOLDED_HISTORY_H
+#define FOLDED_HISTORY_H
+
+#include <cstring>
+
+// smallest power of two >= n, at least one 64-bit word
+constexpr int history_capacity(int n)
+{
+	return (n <= 64) ? 64 : 2 * history_capacity((n + 1) / 2);
+}
+
+// circular buffer of at least the last LENGTH history bits; bit(0) is the most recent
+template <int LENGTH>
+class history_buffer
+{
+  public:
+	static const int SIZE = history_capacity(LENGTH);
+	static const int WORDS = SIZE / 64;
+
+	history_buffer(void) : ptr(0)
+	{
+		memset(words, 0, sizeof(words));
+	}
+
+	void push(bool b)
+	{
+		ptr = (ptr - 1) & (SIZE - 1);
+		unsigned long long mask = 1ull << (ptr & 63);
+		words[ptr >> 6] = (words[ptr >> 6] & ~mask) | (-(unsigned long long)b & mask); // no data-dependent branch
+	}
+
+	bool bit(int i) const
+	{
+		int p = (ptr + i) & (SIZE - 1);
+		return (words[p >> 6] >> (p & 63)) & 1;
+	}
+
+	// bits [start, start + n) as an integer whose bit 0 is bit(start); n <= 32
+	unsigned int window(int start, int n) const
+	{
+		int p = (ptr + start) & (SIZE - 1);
+		int w = p >> 6, off = p & 63;
+		// always merge in the next word; a branch on wrapping mispredicts as ptr moves
+		unsigned long long raw = (words[w] >> off) | ((words[(w + 1) & (WORDS - 1)] << 1) << (63 - off));
+		return raw & ((1ull << n) - 1);
+	}
+
+  private:
+	unsigned long long words[WORDS];
+	int ptr;
+};
+
+// a long shift register kept as N segments of SEG bits, segment(0) holding
+// the newest bits; what the perceptrons index their weight tables with.
+// Pushing k bits moves the top k bits of each segment into the next one, so
+// a push costs O(N) however long the history is, and a copy can be extended
+// with VPC's virtual branches without touching the original
+template <int N, int SEG>
+class segmented_history
+{
+  public:
+	static_assert(SEG >= 1 && SEG <= 32, "history segments are at most 32 bits");
+
+	segmented_history(void)
+	{
+		memset(seg, 0, sizeof(seg));
+	}
+
+	// shift in the low k bits of 'bits' (k <= SEG); bit 0 is the newest
+	void push(unsigned int bits, int k)
+	{
+		for (int i = N - 1; i > 0; i--)
+			seg[i] = ((seg[i] << k) | (seg[i - 1] >> (SEG - k))) & MASK;
+		seg[0] = ((seg[0] << k) | (bits & ((1ull << k) - 1))) & MASK;
+	}
+
+	// history bits [i * SEG, (i + 1) * SEG)
+	unsigned int segment(int i) const
+	{
+		return seg[i];
+	}
+
+  private:
+	static const unsigned long long MASK = (1ull << SEG) - 1;
+
+	unsigned long long seg[N];
+};
+
+// k hashed bits of a branch target (k <= 8), for target-history registers
+inline unsigned int target_bits(unsigned int target, int k)
+{
+	return (target ^ (target >> k) ^ (target >> (2 * k))) & ((1u << k) - 1);
+}
+
+// the last 'original' history bits folded down to 'compressed' bits
+class folded_history
+{
+  public:
+	unsigned int comp;
+
+	folded_history(void) : comp(0), compressed(0), original(0), outpoint(0) {}
+
+	void init(int original_length, int compressed_length)
+	{
+		comp = 0;
+		original = original_length;
+		compressed = compressed_length;
+		outpoint = original_length % compressed_length;
+	}
+
+	// call after the new bit has been pushed into h
+	template <int LENGTH>
+	void update(const history_buffer<LENGTH> &h)
+	{
+		update(h.bit(0), h.bit(original));
+	}
+
+	// shift in 'in'; 'out' is the bit leaving the window, i.e. the bit at
+	// position 'original' once 'in' has been pushed
+	void update(bool in, bool out)
+	{
+		comp = (comp << 1) ^ in;
+		comp ^= (unsigned int)out << outpoint;
+		comp ^= comp >> compressed;
+		comp &= (1u << compressed) - 1;
+	}
+
+	int length(void) const
+	{
+		return original;
+	}
+
+  private:
+	int compressed, original, outpoint;
+};
+
+#endif
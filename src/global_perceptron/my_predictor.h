@@ -6,63 +6,114 @@
 #include <cstddef>
 #include <cstring>
 
+#include "../access_counter.h"
+#include "../bias_filter.h"
+#include "../budget.h"
+#include "../folded_history.h"
+#include "../training_threshold.h"
+
 #define H 59		 //History length or weights per perceptron
 #define NUM_WTS 1024 //Number of weights per table
 #define TARGET_BITS 15
 #define MAX_WEIGHT 127
 #define MIN_WEIGHT -128
+#define THETA_MODE THETA_ADAPTIVE // see training_threshold.h
+#define BIAS_FILTER_ENTRIES 4096  // bias-free filtering, see bias_filter.h; 0 disables
 
 class my_update : public branch_update
 {
   public:
 	unsigned int weight_index;
 	int perceptron_output;
+	bool filtered; // predicted by the bias filter
 
 	my_update(void)
 	{
 		weight_index = 0;
 		perceptron_output = 0;
+		filtered = false;
 	}
 };
 
 class my_predictor : public branch_predictor
 {
   public:
-	static const unsigned int THETA = 127; // 1.93*H+14
+	static const unsigned int THETA = 127; // 1.93*H+14; initial value if adaptive
 	my_update u;
 	branch_info bi;
 
-	unsigned int history;
+	history_buffer<H> history;
 
 	char weight_tables[H + 1][NUM_WTS];
 	unsigned int targets[1 << TARGET_BITS];
 
-	my_predictor(void) : history(0)
+	typedef training_threshold<(THETA_MODE == THETA_PER_TABLE) ? H + 1 : 1, THETA_MODE != THETA_FIXED> threshold_type;
+	threshold_type threshold;
+	bias_filter<BIAS_FILTER_ENTRIES> filter;
+	long long predictions;
+	access_counter weight_accesses, btb_accesses, ghr_accesses;
+
+	// Storage budget
+	static constexpr budget_component BUDGET[] = {
+		{"GHR", 1, H},
+		{"Weight tables", (H + 1) * NUM_WTS, 8},
+		{"BTB", 1 << TARGET_BITS, 32},
+		{"Adaptive thresholds (theta + counter)", threshold_type::ENTRIES, threshold_type::ENTRY_BITS},
+		{"Bias filter states", BIAS_FILTER_ENTRIES, 2},
+	};
+	static_assert(budget_bits(BUDGET) <= BUDGET_LIMIT_BITS, "global perceptron exceeds BUDGET_LIMIT_KB");
+
+	my_predictor(void)
+		: threshold(THETA), filter("global perceptron bias filter"), predictions(0),
+		  weight_accesses("global perceptron weight tables", NUM_WTS * 8),
+		  btb_accesses("global perceptron BTB", 32 << TARGET_BITS), ghr_accesses("global perceptron GHR", H)
 	{
 		memset(weight_tables, 0, sizeof(weight_tables));
 		memset(targets, 0, sizeof(targets));
 	}
 
+	void print_budget(FILE *f)
+	{
+		::print_budget(f, "global perceptron", BUDGET);
+	}
+
+	void report(FILE *f, bool)
+	{
+		fprintf(f, "Perceptron statistics\n");
+		threshold.report(f, predictions);
+		filter.report(f);
+	}
+
 	branch_update *predict(branch_info &b)
 	{
 		bi = b;
-		if (b.br_flags & BR_CONDITIONAL)
+		bool biased_direction;
+		u.filtered = false;
+		if ((b.br_flags & BR_CONDITIONAL) && filter.lookup(b.address, biased_direction))
+		{
+			u.filtered = true; // always/never taken so far; no weights read
+			u.direction_prediction(biased_direction);
+			predictions++;
+		}
+		else if (b.br_flags & BR_CONDITIONAL)
 		{
-			unsigned int history_lob = history % NUM_WTS;
+			unsigned int history_lob = history.window(0, bits_for(NUM_WTS));
 			unsigned int address_lob = b.address % NUM_WTS;
 			u.weight_index = history_lob ^ address_lob;
+			weight_accesses.read(H + 1);
+			ghr_accesses.read();
 
 			u.perceptron_output = weight_tables[0][u.weight_index];
 
 			for (int i = 1; i < H + 1; i++)
 			{
-				unsigned int mask = 1 << (i - 1);
-				if (history & mask) // if history bit is 1
+				if (history.bit(i - 1)) // if history bit is 1
 					u.perceptron_output += weight_tables[i][u.weight_index];
 				else // if history bit is 0 treat as -1 (bipolar conversion)
 					u.perceptron_output -= weight_tables[i][u.weight_index];
 			}
 
+			predictions++;
 			if (u.perceptron_output >= 0)
 			{
 				u.direction_prediction(true);
@@ -79,6 +130,7 @@ class my_predictor : public branch_predictor
 		if (b.br_flags & BR_INDIRECT)
 		{
 			u.target_prediction(targets[b.address & ((1 << TARGET_BITS) - 1)]);
+			btb_accesses.read();
 		}
 		return &u;
 	}
@@ -90,8 +142,16 @@ class my_predictor : public branch_predictor
 			bool direction_prediction = ((my_update *)u)->direction_prediction();
 			int prediction_output = ((my_update *)u)->perceptron_output;
 
-			if ((direction_prediction != taken) || (abs(prediction_output) <= THETA))
+			bool mispredicted = direction_prediction != taken;
+			int magnitude = abs(prediction_output);
+			bool filtered = ((my_update *)u)->filtered; // no weights were read
+			filter.update(bi.address, taken);
+			if (!filtered && THETA_MODE == THETA_PER_TABLE)
+				train_per_table(((my_update *)u)->weight_index, mispredicted, magnitude, taken);
+			else if (!filtered && threshold.train(0, mispredicted, magnitude, mispredicted))
 			{
+				weight_accesses.write(H + 1);
+
 				// update the bias
 				char *bias = &weight_tables[0][((my_update *)u)->weight_index];
 				if (direction_prediction == true)
@@ -108,7 +168,7 @@ class my_predictor : public branch_predictor
 				// update the weights
 				for (int i = 1; i < H + 1; i++)
 				{
-					bool history_bit = history & (1 << (i - 1));
+					bool history_bit = history.bit(i - 1);
 					char *weight = &weight_tables[i][((my_update *)u)->weight_index];
 
 					if (history_bit == taken)
@@ -124,13 +184,39 @@ class my_predictor : public branch_predictor
 				}
 			}
 
-			history <<= 1;
-			history |= taken;
+			bool biased_direction;
+			if (!filter.biased(bi.address, biased_direction)) // biased branches stay out of the history
+			{
+				history.push(taken);
+				ghr_accesses.write();
+			}
 		}
 
 		if (bi.br_flags & BR_INDIRECT)
 		{
 			targets[bi.address & ((1 << TARGET_BITS) - 1)] = target;
+			btb_accesses.write();
+		}
+	}
+
+  private:
+	// each table trains under its own threshold, which rises when the
+	// table's weight pulled the wrong way in a misprediction
+	void train_per_table(unsigned int index, bool mispredicted, int magnitude, bool taken)
+	{
+		for (int i = 0; i < H + 1; i++)
+		{
+			char *weight = &weight_tables[i][index];
+			bool agree = i ? history.bit(i - 1) == taken : taken;
+			bool wrong = mispredicted && ((*weight >= 0) != agree);
+			weight_accesses.read();
+			if (!threshold.train(i, mispredicted, magnitude, wrong))
+				continue;
+			weight_accesses.write();
+			if (agree && *weight < MAX_WEIGHT)
+				(*weight)++;
+			else if (!agree && *weight > MIN_WEIGHT)
+				(*weight)--;
 		}
 	}
 };
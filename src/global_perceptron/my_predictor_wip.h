@@ -7,6 +7,8 @@
 #include <cstring>
 #include <bitset>
 
+#include "../budget.h"
+
 #define H 59			// History length or weights per perceptron
 #define NUM_WTS 1024	// Number of weights per table
 #define MAX_WEIGHT 127  // Max value of bias/weight
@@ -57,6 +59,15 @@ class my_predictor : public branch_predictor
 	unsigned int targets[NUM_TARGETS];
 	unsigned char lfu_ctr[NUM_LFU_COUNTERS][MAX_VPC_ITERS];
 
+	// Storage budget
+	static constexpr budget_component BUDGET[] = {
+		{"GHR", 1, H},
+		{"Weight tables", (H + 1) * NUM_WTS, 8},
+		{"BTB", NUM_TARGETS, 32},
+		{"LFU counters", NUM_LFU_COUNTERS * MAX_VPC_ITERS, 8},
+	};
+	static_assert(budget_bits(BUDGET) <= BUDGET_LIMIT_BITS, "global perceptron + VPC exceeds BUDGET_LIMIT_KB");
+
 	my_predictor(void) : history(0)
 	{
 		memset(weight_tables, 0, sizeof(weight_tables));
@@ -64,6 +75,11 @@ class my_predictor : public branch_predictor
 		memset(lfu_ctr, 0, sizeof(lfu_ctr));
 	}
 
+	void print_budget(FILE *f)
+	{
+		::print_budget(f, "global perceptron + VPC", BUDGET);
+	}
+
 	/* Prediction Algorithm
 	*/
 	branch_update *predict(branch_info &b)
@@ -105,8 +121,7 @@ class my_predictor : public branch_predictor
 
 		for (int i = 1; i < H + 1; i++) // Get the weights of the perceptron
 		{
-			unsigned int mask = 1 << (i - 1); // add or subtract based on history bit
-			if (history.to_ulong() & mask)	// if history bit is 1
+			if (history[i - 1]) // add or subtract based on history bit; if history bit is 1
 				u.perceptron_output += weight_tables[i][u.weight_index];
 			else // if history bit is 0 treat as -1 (bipolar conversion)
 				u.perceptron_output -= weight_tables[i][u.weight_index];
@@ -164,7 +179,7 @@ class my_predictor : public branch_predictor
 			// Update the weights
 			for (int i = 1; i < H + 1; i++)
 			{
-				bool history_bit = history.to_ulong() & (1 << (i - 1));
+				bool history_bit = history[i - 1];
 				char *weight = &weight_tables[i][((my_update *)u)->weight_index];
 
 				if (history_bit == taken) // increment the weight if history_bit matches the prediction
@@ -3,6 +3,11 @@
 // It has a simple 32,768-entry gshare with a history length of 15 and a
 // simple direct-mapped branch target buffer for indirect branch prediction.
 
+#include "../access_counter.h"
+#include "../alias_tracker.h"
+#include "../budget.h"
+#include "../packed_table.h"
+
 class my_update : public branch_update
 {
   public:
@@ -17,15 +22,37 @@ class my_predictor : public branch_predictor
     my_update u;
     branch_info bi;
     unsigned int history;
-    unsigned char tab[1 << TABLE_BITS];
+    packed_table<2, 1 << TABLE_BITS, false> tab; // 2-bit saturating counters
     unsigned int targets[1 << TABLE_BITS];
+    access_counter pht_accesses, btb_accesses, ghr_accesses;
+    shadow_tags<1 << TABLE_BITS> pht_shadow, btb_shadow; // last PC to write each entry
+
+    // Storage budget
+    static constexpr budget_component BUDGET[] = {
+        {"GHR", 1, HISTORY_LENGTH},
+        {"Pattern history table", 1 << TABLE_BITS, 2},
+        {"BTB", 1 << TABLE_BITS, 32},
+    };
+    static_assert(budget_bits(BUDGET) <= BUDGET_LIMIT_BITS, "gshare exceeds BUDGET_LIMIT_KB");
 
-    my_predictor(void) : history(0)
+    my_predictor(void)
+        : history(0), pht_accesses("gshare pattern history table", 2 << TABLE_BITS),
+          btb_accesses("gshare BTB", 32 << TABLE_BITS), ghr_accesses("gshare GHR", HISTORY_LENGTH)
     {
-        memset(tab, 0, sizeof(tab));
         memset(targets, 0, sizeof(targets));
     }
 
+    void print_budget(FILE *f)
+    {
+        ::print_budget(f, "gshare", BUDGET);
+    }
+
+    void report(FILE *f, bool)
+    {
+        pht_shadow.report(f, "gshare pattern history table");
+        btb_shadow.report(f, "gshare BTB");
+    }
+
     branch_update *predict(branch_info &b)
     {
         bi = b;
@@ -33,7 +60,9 @@ class my_predictor : public branch_predictor
         {
             u.index =
                 (history << (TABLE_BITS - HISTORY_LENGTH)) ^ (b.address & ((1 << TABLE_BITS) - 1));
-            u.direction_prediction(tab[u.index] >> 1);
+            u.direction_prediction(tab.get(u.index) >> 1);
+            pht_accesses.read();
+            ghr_accesses.read();
         }
         else
         {
@@ -42,6 +71,7 @@ class my_predictor : public branch_predictor
         if (b.br_flags & BR_INDIRECT)
         {
             u.target_prediction(targets[b.address & ((1 << TABLE_BITS) - 1)]);
+            btb_accesses.read();
         }
         return &u;
     }
@@ -50,24 +80,31 @@ class my_predictor : public branch_predictor
     {
         if (bi.br_flags & BR_CONDITIONAL)
         {
-            unsigned char *c = &tab[((my_update *)u)->index];
-            if (taken)
-            {
-                if (*c < 3)
-                    (*c)++;
-            }
-            else
+            unsigned int index = ((my_update *)u)->index;
+            if (ALIAS_ANALYSIS)
             {
-                if (*c > 0)
-                    (*c)--;
+                int kind = pht_shadow.use(index, bi.address, (tab.get(index) >> 1) == taken);
+                pht_shadow.resolve(u->direction_prediction() != taken, kind == ALIAS_DESTRUCTIVE);
+                pht_shadow.own(index, bi.address);
             }
+            tab.train(index, taken);
+            pht_accesses.write();
+            ghr_accesses.write();
             history <<= 1;
             history |= taken;
             history &= (1 << HISTORY_LENGTH) - 1;
         }
         if (bi.br_flags & BR_INDIRECT)
         {
-            targets[bi.address & ((1 << TABLE_BITS) - 1)] = target;
+            unsigned int index = bi.address & ((1 << TABLE_BITS) - 1);
+            if (ALIAS_ANALYSIS)
+            {
+                int kind = btb_shadow.use(index, bi.address, targets[index] == target);
+                btb_shadow.resolve(targets[index] != target, kind == ALIAS_DESTRUCTIVE);
+                btb_shadow.own(index, bi.address);
+            }
+            targets[index] = target;
+            btb_accesses.write();
         }
     }
 };
@@ -0,0 +1,218 @@
+// host_counters.h
+// Author: Ankur Roy Chowdhury
+// Host performance counters of the simulator itself (Linux perf_event_open),
+// to see whether the predictor's tables and the trace reader's tables fit in
+// the host caches. One counter group per phase of a simulated branch: trace
+// decode, predict and update, plus one for the whole run. Starting and
+// stopping a group takes a system call, so the phases are only measured on
+// one branch in every 'period'; the whole-run group counts everything.
+// Only user-mode events are counted. A phase's counts include the cost of
+// the system calls that bracket it, so compare phases with each other rather
+// than with the whole run.
+//
+// Each event is opened on its own, so the ones the host does not offer
+// (hardware events in most containers and VMs) are reported as unavailable
+// and the rest still work; the task clock is a software event and nearly
+// always available.
+
+#ifndef HOST_COUNTERS_H
+#define HOST_COUNTERS_H
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+class host_counters
+{
+  public:
+	enum phase
+	{
+		DECODE = 0,	// read_trace()
+		PREDICT = 1,	// predict() and the driver's accounting
+		UPDATE = 2,	// update()
+		WHOLE_RUN = 3,	// everything, every branch
+		PHASES = 4,
+	};
+
+	static const int EVENTS = 6;
+
+	explicit host_counters(int sample_period) : period(sample_period > 0 ? sample_period : 1)
+	{
+		memset(spans, 0, sizeof(spans));
+		for (int p = 0; p < PHASES; p++)
+		{
+			leader[p] = -1;
+			for (int e = 0; e < EVENTS; e++)
+				fd[p][e] = -1;
+		}
+		for (int e = 0; e < EVENTS; e++)
+			error[e] = 0;
+#ifdef __linux__
+		for (int p = 0; p < PHASES; p++)
+		{
+			for (int e = 0; e < EVENTS; e++)
+			{
+				fd[p][e] = open_event(e, leader[p]);
+				if (fd[p][e] < 0)
+					error[e] = errno;
+				else if (leader[p] < 0)
+					leader[p] = fd[p][e];
+			}
+		}
+#else
+		for (int e = 0; e < EVENTS; e++)
+			error[e] = ENOSYS;
+#endif
+	}
+
+	~host_counters(void)
+	{
+#ifdef __linux__
+		for (int p = 0; p < PHASES; p++)
+			for (int e = 0; e < EVENTS; e++)
+				if (fd[p][e] >= 0)
+					close(fd[p][e]);
+#endif
+	}
+
+	bool available(void) const
+	{
+		return leader[WHOLE_RUN] >= 0;
+	}
+
+	// whether branch n is one whose phases are measured
+	bool sampled(long long n) const
+	{
+		return available() && n % period == 0;
+	}
+
+	void start(int p)
+	{
+#ifdef __linux__
+		if (leader[p] >= 0)
+			ioctl(leader[p], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+	}
+
+	void stop(int p)
+	{
+#ifdef __linux__
+		if (leader[p] >= 0)
+			ioctl(leader[p], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+#endif
+		spans[p]++;
+	}
+
+	void report(FILE *f, long long branches)
+	{
+		if (!available())
+		{
+			fprintf(f, "Host counters unavailable (perf_event_open: %s)\n", strerror(error[0]));
+			return;
+		}
+
+		static const char *const phase_names[PHASES] = {"decode", "predict", "update", "whole run"};
+		fprintf(f, "Host counters per simulated branch (phases sampled on 1 in %d branches)\n", period);
+		fprintf(f, "  %-10s", "phase");
+		for (int e = 0; e < EVENTS; e++)
+			if (fd[WHOLE_RUN][e] >= 0)
+				fprintf(f, " %14s", event_name(e));
+		fprintf(f, "\n");
+
+		for (int p = 0; p < PHASES; p++)
+		{
+			double value[EVENTS];
+			long long n = p == WHOLE_RUN ? branches : spans[p];
+			if (n == 0 || !read_group(p, value))
+				continue;
+			fprintf(f, "  %-10s", phase_names[p]);
+			for (int e = 0; e < EVENTS; e++)
+				if (fd[WHOLE_RUN][e] >= 0)
+					fprintf(f, " %14.2f", value[e] / n);
+			fprintf(f, "\n");
+		}
+
+		for (int e = 0; e < EVENTS; e++)
+			if (fd[WHOLE_RUN][e] < 0)
+				fprintf(f, "  %s unavailable (%s)\n", event_name(e), strerror(error[e]));
+	}
+
+  private:
+	int period;
+	int fd[PHASES][EVENTS];	// -1: not opened
+	int leader[PHASES];	// first event opened in each phase's group
+	int error[EVENTS];	// errno of the last failed open of each event
+	long long spans[PHASES];// start/stop pairs measured
+
+	static const char *event_name(int e)
+	{
+		static const char *const names[EVENTS] = {"task-clock ns", "cycles", "instructions",
+							  "L1D misses", "LLC misses", "branch misses"};
+		return names[e];
+	}
+
+#ifdef __linux__
+	static int open_event(int e, int group)
+	{
+		static const unsigned int type[EVENTS] = {PERF_TYPE_SOFTWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+							  PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE};
+		static const unsigned long long config[EVENTS] = {
+			PERF_COUNT_SW_TASK_CLOCK,
+			PERF_COUNT_HW_CPU_CYCLES,
+			PERF_COUNT_HW_INSTRUCTIONS,
+			PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+			PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+			PERF_COUNT_HW_BRANCH_MISSES,
+		};
+
+		struct perf_event_attr a;
+		memset(&a, 0, sizeof(a));
+		a.size = sizeof(a);
+		a.type = type[e];
+		a.config = config[e];
+		a.disabled = group < 0; // members follow their leader
+		a.exclude_kernel = 1;
+		a.exclude_hv = 1;
+		a.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID | PERF_FORMAT_TOTAL_TIME_ENABLED |
+				PERF_FORMAT_TOTAL_TIME_RUNNING;
+		return syscall(SYS_perf_event_open, &a, 0, -1, group, 0);
+	}
+#endif
+
+	// the group's counts, scaled up if the kernel multiplexed it
+	bool read_group(int p, double *value) const
+	{
+#ifdef __linux__
+		unsigned long long buf[3 + 2 * EVENTS];
+		if (leader[p] < 0 || read(leader[p], buf, sizeof(buf)) < (ssize_t)(3 * sizeof(buf[0])))
+			return false;
+		double scale = buf[2] ? buf[1] / (double)buf[2] : 0;
+		for (int e = 0; e < EVENTS; e++)
+		{
+			value[e] = 0;
+			if (fd[p][e] < 0)
+				continue;
+			unsigned long long id;
+			if (ioctl(fd[p][e], PERF_EVENT_IOC_ID, &id) < 0)
+				continue;
+			for (unsigned long long i = 0; i < buf[0] && i < EVENTS; i++)
+				if (buf[4 + 2 * i] == id)
+					value[e] = buf[3 + 2 * i] * scale;
+		}
+		return true;
+#else
+		(void)p;
+		(void)value;
+		return false;
+#endif
+	}
+};
+
+#endif
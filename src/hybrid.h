@@ -0,0 +1,168 @@
+// hybrid.h
+// Author: Ankur Roy Chowdhury
+// Tournament (hybrid) predictor over any branch_predictor subclasses. All
+// components predict and train on every branch; a chooser table indexed by
+// PC, or by PC and global history, keeps a 2-bit counter per component and
+// the component with the highest counter supplies the direction. The chooser
+// is only trained when the components disagree: the counters of the
+// components that were right go up, the others down. With two components
+// this is McFarling's combining predictor. Indirect targets come from the
+// first component.
+
+#ifndef HYBRID_H
+#define HYBRID_H
+
+#include <cstdio>
+#include <tuple>
+#include <utility>
+
+#include "budget.h"
+#include "packed_table.h"
+
+// what the chooser table is indexed with
+enum chooser_index
+{
+	CHOOSE_BY_PC = 0,	// branch address
+	CHOOSE_BY_HISTORY = 1,	// branch address xor global history
+};
+
+template <int LOG_ENTRIES, int INDEX, class... P>
+class hybrid_predictor : public branch_predictor
+{
+  public:
+	static const int N = sizeof...(P);
+	static const int ENTRIES = 1 << LOG_ENTRIES;
+	static const int CTR_BITS = 2;
+
+	static_assert(N >= 2, "a hybrid needs at least two components");
+	static_assert(INDEX == CHOOSE_BY_PC || INDEX == CHOOSE_BY_HISTORY, "INDEX is a chooser_index");
+
+	std::tuple<P...> parts;
+	branch_predictor *component[N];		// parts, through the common interface
+	branch_update *part_update[N];		// each component's prediction of the current branch
+
+	branch_update u;
+	branch_info bi;
+
+	packed_table<CTR_BITS, N * ENTRIES, false> chooser;	// counter of component i at entry e: e * N + i
+	unsigned int history;					// conditional outcomes, for CHOOSE_BY_HISTORY
+	unsigned int index;					// chooser entry of the current branch
+	int chosen;						// component that supplied the direction
+
+	long long predictions, disagreements, chosen_count[N], chosen_correct, any_correct, part_correct[N];
+
+	static constexpr budget_component BUDGET[] = {
+		{"Chooser counters", (unsigned long long)N * ENTRIES, CTR_BITS},
+		{"Chooser history", INDEX == CHOOSE_BY_HISTORY ? 1 : 0, LOG_ENTRIES},
+	};
+	static constexpr unsigned long long TOTAL_BUDGET_BITS = (predictor_budget_bits<P>(0) + ...) + budget_bits(BUDGET);
+	static_assert(TOTAL_BUDGET_BITS <= BUDGET_LIMIT_BITS, "hybrid_predictor exceeds BUDGET_LIMIT_KB");
+
+	hybrid_predictor(void) : history(0), index(0), chosen(0), predictions(0), disagreements(0), chosen_correct(0), any_correct(0)
+	{
+		bind(std::index_sequence_for<P...>());
+		for (int i = 0; i < N; i++)
+		{
+			part_update[i] = 0;
+			chosen_count[i] = 0;
+			part_correct[i] = 0;
+		}
+		for (int e = 0; e < N * ENTRIES; e++)
+			chooser.set(e, 1 << (CTR_BITS - 1)); // weakly trusted
+	}
+
+	void print_budget(FILE *f)
+	{
+		for (int i = 0; i < N; i++)
+			component[i]->print_budget(f);
+		::print_budget(f, "hybrid chooser", BUDGET);
+		print_budget_total(f, TOTAL_BUDGET_BITS, "hybrid");
+	}
+
+	void report(FILE *f, bool detailed)
+	{
+		for (int i = 0; i < N; i++)
+			component[i]->report(f, detailed);
+		fprintf(f, "Hybrid chooser statistics\n");
+		fprintf(f, "  conditional predictions         %lld\n", predictions);
+		if (predictions == 0)
+			return;
+		fprintf(f, "  components disagree             %0.4f\n", disagreements / (double)predictions);
+		if (disagreements)
+		{
+			fprintf(f, "  chooser right on disagreement   %0.4f\n", chosen_correct / (double)disagreements);
+			fprintf(f, "  some component right            %0.4f\n", any_correct / (double)disagreements);
+		}
+		fprintf(f, "  %9s %10s %14s\n", "component", "chosen %", "right (disagr.)");
+		for (int i = 0; i < N; i++)
+			fprintf(f, "  %9d %10.3f %14.4f\n", i, 100.0 * chosen_count[i] / predictions,
+				disagreements ? part_correct[i] / (double)disagreements : 0.0);
+	}
+
+	branch_update *predict(branch_info &b)
+	{
+		bi = b;
+		for (int i = 0; i < N; i++)
+			part_update[i] = component[i]->predict(b);
+
+		u.direction_prediction(part_update[0]->direction_prediction());
+		u.target_prediction(part_update[0]->target_prediction());
+		if (b.br_flags & BR_CONDITIONAL)
+		{
+			index = chooser_entry(b.address);
+			chosen = 0;
+			for (int i = 1; i < N; i++)
+				if (chooser.get(index * N + i) > chooser.get(index * N + chosen))
+					chosen = i;
+			u.direction_prediction(part_update[chosen]->direction_prediction());
+		}
+		return &u;
+	}
+
+	void update(branch_update *, bool taken, unsigned int target)
+	{
+		if (bi.br_flags & BR_CONDITIONAL)
+		{
+			predictions++;
+			chosen_count[chosen]++;
+
+			bool agree = true;
+			for (int i = 1; i < N; i++)
+				agree &= part_update[i]->direction_prediction() == part_update[0]->direction_prediction();
+			if (!agree)
+			{
+				disagreements++;
+				chosen_correct += part_update[chosen]->direction_prediction() == taken;
+				bool any = false;
+				for (int i = 0; i < N; i++)
+				{
+					bool right = part_update[i]->direction_prediction() == taken;
+					part_correct[i] += right;
+					any |= right;
+					chooser.train(index * N + i, right);
+				}
+				any_correct += any;
+			}
+			history = ((history << 1) | taken) & (ENTRIES - 1);
+		}
+
+		for (int i = 0; i < N; i++)
+			component[i]->update(part_update[i], taken, target);
+	}
+
+  private:
+	template <size_t... I>
+	void bind(std::index_sequence<I...>)
+	{
+		branch_predictor *c[] = {&std::get<I>(parts)...};
+		for (int i = 0; i < N; i++)
+			component[i] = c[i];
+	}
+
+	unsigned int chooser_entry(unsigned int pc) const
+	{
+		return ((INDEX == CHOOSE_BY_HISTORY) ? (pc ^ history) : pc) & (ENTRIES - 1);
+	}
+};
+
+#endif
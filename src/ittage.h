@@ -0,0 +1,327 @@
+// ittage.h
+// Author: Ankur Roy Chowdhury
+// ITTAGE indirect target predictor (Seznec, "A 64-Kbytes ITTAGE indirect branch
+// predictor", JWAC-2 2011). A PC-indexed base target table is backed by
+// NUM_TABLES partially tagged tables indexed with geometrically increasing
+// global history lengths. The longest matching table provides the target, so
+// a prediction is one parallel lookup of every table.
+
+#ifndef ITTAGE_H
+#define ITTAGE_H
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "budget.h"
+#include "folded_history.h"
+
+template <int LOG_BASE_, int LOG_TABLE_, int NUM_TABLES_, int MIN_HIST_, int MAX_HIST_, int TAG_BITS_>
+struct ittage_params
+{
+	static const int LOG_BASE = LOG_BASE_;		// log2 of base target table entries
+	static const int LOG_TABLE = LOG_TABLE_;	// log2 of entries per tagged table
+	static const int NUM_TABLES = NUM_TABLES_;	// number of tagged tables
+	static const int MIN_HIST = MIN_HIST_;		// history length of the first tagged table
+	static const int MAX_HIST = MAX_HIST_;		// history length of the last tagged table
+	static const int TAG_BITS = TAG_BITS_;		// partial tag width
+
+	static_assert(NUM_TABLES_ >= 2, "ITTAGE needs at least two tagged tables");
+	static_assert(MIN_HIST_ < MAX_HIST_ && MAX_HIST_ < 2048, "history lengths must grow and fit the history buffer");
+};
+
+typedef ittage_params<
+	12,	// LOG_BASE: 4096-entry base table
+	9,	// LOG_TABLE: 512 entries per tagged table
+	8,	// NUM_TABLES
+	4,	// MIN_HIST
+	640,	// MAX_HIST
+	11>	// TAG_BITS
+	ittage_config;
+
+class ittage_update : public branch_update
+{
+  public:
+	int provider;		// tagged table that supplied the target, -1 for the base table
+	int alt;		// next longest match, -1 for the base table
+	unsigned int provider_target;
+	unsigned int alt_target;
+	bool alt_valid;		// the alternate is a tagged hit or a trained base entry
+	unsigned int base_index;
+	unsigned int index[32];	// per-table index and tag computed at prediction time
+	unsigned int tag[32];
+
+	ittage_update(void) : provider(-1), alt(-1), provider_target(0), alt_target(0), alt_valid(false), base_index(0)
+	{
+		memset(index, 0, sizeof(index));
+		memset(tag, 0, sizeof(tag));
+	}
+};
+
+template <class C>
+class ittage_predictor : public branch_predictor
+{
+  public:
+	static const int LOG_BASE = C::LOG_BASE;
+	static const int LOG_TABLE = C::LOG_TABLE;
+	static const int NUM_TABLES = C::NUM_TABLES;
+	static const int TAG_BITS = C::TAG_BITS;
+	static const int CTR_MAX = 3;		  // 2-bit confidence counters
+	static const int U_RESET_PERIOD = 1 << 18; // indirect updates between useful-bit resets
+
+	static_assert(NUM_TABLES <= 32, "ittage_update holds at most 32 tables");
+
+	struct base_entry
+	{
+		bool valid;
+		unsigned int target;
+		unsigned char ctr;
+	};
+
+	struct tagged_entry
+	{
+		bool valid;
+		unsigned int tag;
+		unsigned int target;
+		unsigned char ctr;
+		unsigned char u;	// useful bit
+	};
+
+	ittage_update u;
+	branch_info bi;
+
+	base_entry base[1 << LOG_BASE];
+	tagged_entry tables[NUM_TABLES][1 << LOG_TABLE];
+	int hist_len[NUM_TABLES];
+
+	history_buffer<2048> ghist;			// global history: conditional outcomes and indirect target bits
+	unsigned int phist;				// path history: one address bit per branch
+	folded_history fold_index[NUM_TABLES];
+	folded_history fold_tag[2][NUM_TABLES];
+
+	unsigned int updates;				// indirect updates since the last useful-bit reset
+	unsigned int alloc_seed;			// pseudo-random choice of allocation table
+	long long provider_hist[NUM_TABLES + 1];	// predictions by provider (0 = base table)
+
+	static constexpr budget_component BUDGET[] = {
+		{"Base target table (valid + target + ctr)", 1 << LOG_BASE, 1 + 32 + 2},
+		{"Tagged tables (valid + tag + target + ctr + u)", (unsigned long long)NUM_TABLES << LOG_TABLE, 1 + TAG_BITS + 32 + 2 + 1},
+		{"Global history", 1, C::MAX_HIST},
+		{"Path history", 1, 16},
+		{"Folded histories", 3 * NUM_TABLES, LOG_TABLE},
+		{"Useful-bit reset counter", 1, 18},
+	};
+	static_assert(budget_bits(BUDGET) <= BUDGET_LIMIT_BITS, "ittage_predictor exceeds BUDGET_LIMIT_KB");
+
+	ittage_predictor(void) : phist(0), updates(0), alloc_seed(0)
+	{
+		memset(base, 0, sizeof(base));
+		memset(tables, 0, sizeof(tables));
+		memset(provider_hist, 0, sizeof(provider_hist));
+
+		// geometric history lengths between MIN_HIST and MAX_HIST
+		for (int i = 0; i < NUM_TABLES; i++)
+		{
+			double ratio = pow((double)C::MAX_HIST / C::MIN_HIST, (double)i / (NUM_TABLES - 1));
+			hist_len[i] = (int)(C::MIN_HIST * ratio + 0.5);
+			fold_index[i].init(hist_len[i], LOG_TABLE);
+			fold_tag[0][i].init(hist_len[i], TAG_BITS);
+			fold_tag[1][i].init(hist_len[i], TAG_BITS - 1);
+		}
+	}
+
+	void print_budget(FILE *f)
+	{
+		::print_budget(f, "ITTAGE", BUDGET);
+	}
+
+	void report(FILE *f, bool)
+	{
+		long long n = 0;
+		for (int i = 0; i <= NUM_TABLES; i++)
+			n += provider_hist[i];
+		fprintf(f, "ITTAGE statistics\n");
+		fprintf(f, "  indirect predictions            %lld\n", n);
+		fprintf(f, "  lookup rounds per prediction    1 (%d tables in parallel)\n", NUM_TABLES + 1);
+		if (n == 0)
+			return;
+		fprintf(f, "  %8s %8s %12s %8s\n", "provider", "history", "predictions", "%");
+		for (int i = 0; i <= NUM_TABLES; i++)
+		{
+			char name[8] = "base";
+			if (i)
+				snprintf(name, sizeof(name), "T%d", i);
+			fprintf(f, "  %8s %8d %12lld %8.3f\n", name, i ? hist_len[i - 1] : 0, provider_hist[i],
+				100.0 * provider_hist[i] / n);
+		}
+	}
+
+	branch_update *predict(branch_info &b)
+	{
+		bi = b;
+		u = ittage_update();
+		u.direction_prediction(true);
+
+		if (b.br_flags & BR_INDIRECT)
+		{
+			u.base_index = b.address & ((1 << LOG_BASE) - 1);
+			for (int i = 0; i < NUM_TABLES; i++)
+			{
+				u.index[i] = table_index(b.address, i);
+				u.tag[i] = table_tag(b.address, i);
+			}
+
+			// longest and second longest matching tables
+			for (int i = NUM_TABLES - 1; i >= 0; i--)
+			{
+				if (!tables[i][u.index[i]].valid || tables[i][u.index[i]].tag != u.tag[i])
+					continue;
+				if (u.provider < 0)
+					u.provider = i;
+				else
+				{
+					u.alt = i;
+					break;
+				}
+			}
+
+			u.alt_target = (u.alt >= 0) ? tables[u.alt][u.index[u.alt]].target : base[u.base_index].target;
+			u.alt_valid = u.alt >= 0 || base[u.base_index].valid;
+			if (u.provider >= 0)
+			{
+				tagged_entry &e = tables[u.provider][u.index[u.provider]];
+				u.provider_target = e.target;
+				// a newly allocated, unconfirmed entry defers to the alternate prediction
+				u.target_prediction((e.ctr == 0 && u.alt_valid) ? u.alt_target : e.target);
+			}
+			else
+			{
+				u.provider_target = u.alt_target;
+				u.target_prediction(u.alt_target);
+			}
+			provider_hist[u.provider + 1]++;
+		}
+		return &u;
+	}
+
+	void update(branch_update *bu, bool taken, unsigned int target)
+	{
+		ittage_update *mu = (ittage_update *)bu;
+
+		if (bi.br_flags & BR_INDIRECT)
+		{
+			bool mispredicted = mu->target_prediction() != target;
+
+			if (mu->provider >= 0)
+			{
+				tagged_entry &e = tables[mu->provider][mu->index[mu->provider]];
+
+				// useful when the provider was right and the alternate would have been wrong
+				if ((mu->provider_target == target) != (mu->alt_target == target))
+					e.u = (mu->provider_target == target);
+
+				train_target(e.target, e.ctr, target);
+
+				// a weak provider also trains the alternate
+				if (e.ctr == 0 && mu->alt < 0)
+					train_base(mu->base_index, target);
+			}
+			else
+				train_base(mu->base_index, target);
+
+			if (mispredicted && mu->provider < NUM_TABLES - 1)
+				allocate(mu, target);
+
+			if (++updates >= (unsigned int)U_RESET_PERIOD)
+			{
+				for (int i = 0; i < NUM_TABLES; i++)
+					for (int j = 0; j < (1 << LOG_TABLE); j++)
+						tables[i][j].u = 0;
+				updates = 0;
+			}
+		}
+
+		// history: one bit per conditional branch, two target bits per indirect branch
+		if (bi.br_flags & BR_CONDITIONAL)
+			push_history(taken);
+		if (bi.br_flags & BR_INDIRECT)
+		{
+			push_history((target >> 2) & 1);
+			push_history((target >> 3) & 1);
+		}
+		if (bi.br_flags & (BR_CONDITIONAL | BR_INDIRECT))
+			phist = ((phist << 1) ^ ((bi.address >> 2) & 1)) & 0xffff;
+	}
+
+  private:
+	unsigned int table_index(unsigned int pc, int i)
+	{
+		unsigned int path = phist & ((1u << (hist_len[i] < 16 ? hist_len[i] : 16)) - 1);
+		unsigned int idx = pc ^ (pc >> (LOG_TABLE - (i % LOG_TABLE))) ^ fold_index[i].comp ^ path ^ (path >> LOG_TABLE);
+		return idx & ((1 << LOG_TABLE) - 1);
+	}
+
+	unsigned int table_tag(unsigned int pc, int i)
+	{
+		return (pc ^ fold_tag[0][i].comp ^ (fold_tag[1][i].comp << 1)) & ((1 << TAG_BITS) - 1);
+	}
+
+	// 2-bit hysteresis: a confident target survives one misprediction
+	static void train_target(unsigned int &stored, unsigned char &ctr, unsigned int target)
+	{
+		if (stored == target)
+		{
+			if (ctr < CTR_MAX)
+				ctr++;
+		}
+		else if (ctr > 0)
+			ctr--;
+		else
+			stored = target;
+	}
+
+	void train_base(unsigned int index, unsigned int target)
+	{
+		train_target(base[index].target, base[index].ctr, target);
+		base[index].valid = true;
+	}
+
+	// allocate one entry in a longer-history table whose useful bit is clear
+	void allocate(ittage_update *mu, unsigned int target)
+	{
+		int start = mu->provider + 1;
+		alloc_seed = alloc_seed * 1103515245 + 12345;
+		if (start < NUM_TABLES - 1 && ((alloc_seed >> 16) & 1)) // skip a table now and then to spread allocations
+			start++;
+
+		for (int i = start; i < NUM_TABLES; i++)
+		{
+			tagged_entry &e = tables[i][mu->index[i]];
+			if (e.u == 0)
+			{
+				e.valid = true;
+				e.tag = mu->tag[i];
+				e.target = target;
+				e.ctr = 0;
+				return;
+			}
+		}
+
+		// no room: age the candidates so a later allocation succeeds
+		for (int i = mu->provider + 1; i < NUM_TABLES; i++)
+			tables[i][mu->index[i]].u = 0;
+	}
+
+	void push_history(bool b)
+	{
+		ghist.push(b);
+		for (int i = 0; i < NUM_TABLES; i++)
+		{
+			fold_index[i].update(ghist);
+			fold_tag[0][i].update(ghist);
+			fold_tag[1][i].update(ghist);
+		}
+	}
+};
+
+#endif
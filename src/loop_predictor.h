@@ -0,0 +1,190 @@
+// loop_predictor.h
+// Author: Ankur Roy Chowdhury
+// Tagged loop predictor (after the loop component of Seznec's TAGE-SC-L).
+// Each entry learns the trip count of one counted loop branch: the number
+// of consecutive executions in the loop direction followed by one exit.
+// Once the same trip count has been seen CONF_MAX times in a row the entry
+// predicts the exit iteration. A global counter decides whether confident
+// loop predictions are trusted over the engine the loop predictor sits
+// beside.
+
+#ifndef LOOP_PREDICTOR_H
+#define LOOP_PREDICTOR_H
+
+#include <cstring>
+
+#include "budget.h"
+
+template <int LOG_SETS, int WAYS, int TAG_BITS, int ITER_BITS = 10>
+class loop_predictor
+{
+  public:
+	static const int SETS = 1 << LOG_SETS;
+	static const int ENTRIES = SETS * WAYS;
+	static const int CONF_MAX = 3;		// 2-bit confidence
+	static const int AGE_MAX = 7;		// 3-bit replacement age
+	static const int ITER_MASK = (1 << ITER_BITS) - 1;
+	static const int USE_MAX = 63;		// 7-bit signed use counter
+	static const int USE_MIN = -64;
+	// valid + tag + past and current trip count + confidence + age + direction
+	static const int ENTRY_BITS = 1 + TAG_BITS + 2 * ITER_BITS + 2 + 3 + 1;
+
+	static_assert(TAG_BITS > 0 && TAG_BITS < 32, "loop tag must be between 1 and 31 bits");
+
+	struct entry
+	{
+		bool valid;
+		unsigned int tag;
+		int past_iter;		// trip count learned so far, 0 while unknown
+		int current_iter;	// executions since the last exit
+		int confidence;		// times past_iter was confirmed
+		int age;		// usefulness; an entry with age 0 may be replaced
+		bool dir;		// direction of the loop body
+	};
+
+	// lookup state handed from predict() to update()
+	struct info_type
+	{
+		bool hit;
+		bool valid;		// entry is confident enough to predict
+		bool prediction;
+		int way;
+	};
+
+	entry sets[SETS][WAYS];
+	int use;			// >= 0: trust confident loop predictions
+	long long provided, correct;	// predictions used, and how many were right
+
+	static constexpr budget_component BUDGET[] = {
+		{"Loop predictor entries", ENTRIES, ENTRY_BITS},
+		{"Loop use counter", 1, 7},
+	};
+	static const int INFO_BITS = 1 + 1 + 1 + bits_for(WAYS);
+
+	loop_predictor(void) : use(-1), provided(0), correct(0)
+	{
+		memset(sets, 0, sizeof(sets));
+	}
+
+	// look pc up; returns true if the entry is confident
+	bool predict(unsigned int pc, info_type &i) const
+	{
+		i.hit = false;
+		i.valid = false;
+		i.prediction = false;
+		i.way = 0;
+
+		const entry *set = sets[pc & (SETS - 1)];
+		for (int w = 0; w < WAYS; w++)
+		{
+			if (!set[w].valid || set[w].tag != tag(pc))
+				continue;
+			i.hit = true;
+			i.way = w;
+			i.valid = set[w].confidence == CONF_MAX;
+			i.prediction = (set[w].current_iter + 1 == set[w].past_iter) ? !set[w].dir : set[w].dir;
+			break;
+		}
+		return i.valid;
+	}
+
+	// final direction given the prediction of the engine beside the loop predictor
+	bool choose(const info_type &i, bool other) const
+	{
+		return (i.valid && use >= 0) ? i.prediction : other;
+	}
+
+	// train with the outcome; 'other' is the prediction of the engine beside
+	// the loop predictor and 'mispredicted' whether the final prediction was wrong
+	void update(unsigned int pc, const info_type &i, bool taken, bool other, bool mispredicted)
+	{
+		entry *set = sets[pc & (SETS - 1)];
+
+		if (i.valid && i.prediction != other)
+		{
+			use += (i.prediction == taken) ? 1 : -1;
+			use = (use > USE_MAX) ? USE_MAX : ((use < USE_MIN) ? USE_MIN : use);
+		}
+		if (i.valid && use >= 0)
+		{
+			provided++;
+			correct += i.prediction == taken;
+		}
+
+		if (!i.hit)
+		{
+			if (mispredicted)
+				allocate(set, pc, taken);
+			return;
+		}
+
+		entry &e = set[i.way];
+		if (e.tag != tag(pc) || !e.valid) // replaced since the lookup
+			return;
+
+		if (i.valid)
+		{
+			if (i.prediction != taken) // the trip count changed; relearn from scratch
+			{
+				e.valid = false;
+				return;
+			}
+			if (i.prediction != other && e.age < AGE_MAX)
+				e.age++;
+		}
+
+		e.current_iter = (e.current_iter + 1) & ITER_MASK;
+		if (e.past_iter != 0 && e.current_iter > e.past_iter) // ran past the learned trip count
+		{
+			e.valid = false;
+			return;
+		}
+
+		if (taken != e.dir) // loop exit
+		{
+			if (e.current_iter == e.past_iter)
+			{
+				if (e.confidence < CONF_MAX)
+					e.confidence++;
+				if (e.past_iter < 3) // too short to be worth an entry
+					e.valid = false;
+			}
+			else if (e.past_iter == 0)
+			{
+				e.past_iter = e.current_iter; // first complete trip
+				e.confidence = 0;
+			}
+			else
+				e.valid = false;
+			e.current_iter = 0;
+		}
+	}
+
+  private:
+	static unsigned int tag(unsigned int pc)
+	{
+		return (pc >> LOG_SETS) & ((1u << TAG_BITS) - 1);
+	}
+
+	// take an invalid or aged-out way, else age the set
+	void allocate(entry *set, unsigned int pc, bool taken)
+	{
+		for (int w = 0; w < WAYS; w++)
+		{
+			if (set[w].valid && set[w].age > 0)
+				continue;
+			set[w].valid = true;
+			set[w].tag = tag(pc);
+			set[w].past_iter = 0;
+			set[w].current_iter = 0;
+			set[w].confidence = 0;
+			set[w].age = AGE_MAX;
+			set[w].dir = !taken; // assume the misprediction was a loop exit
+			return;
+		}
+		for (int w = 0; w < WAYS; w++)
+			set[w].age--;
+	}
+};
+
+#endif
@@ -0,0 +1,84 @@
+// looped_predictor.h
+// Author: Ankur Roy Chowdhury
+// Attaches a loop predictor (loop_predictor.h) to any branch_predictor. The
+// wrapped predictor runs unchanged; for conditional branches the loop
+// predictor looks the branch up too and, when it is confident in a learned
+// trip count and its use counter trusts it, overrides the direction. This
+// catches the exits of counted loops whose trip count is longer than the
+// engine's history. The lookup is one set of WAYS entries, so the per-branch
+// cost is constant.
+
+#ifndef LOOPED_PREDICTOR_H
+#define LOOPED_PREDICTOR_H
+
+#include <cstdio>
+
+#include "budget.h"
+#include "loop_predictor.h"
+
+template <class P, int LOG_SETS = 6, int WAYS = 4, int TAG_BITS = 10>
+class looped_predictor : public branch_predictor
+{
+  public:
+	typedef loop_predictor<LOG_SETS, WAYS, TAG_BITS> loop_type;
+	static constexpr unsigned long long TOTAL_BUDGET_BITS = predictor_budget_bits<P>(0) + budget_bits(loop_type::BUDGET);
+	static_assert(TOTAL_BUDGET_BITS <= BUDGET_LIMIT_BITS, "looped_predictor exceeds BUDGET_LIMIT_KB");
+
+	P inner;
+	loop_type loop;
+
+	branch_update u;
+	branch_update *inner_update;
+	typename loop_type::info_type info;
+	branch_info bi;
+
+	long long overrides, overrides_correct;
+
+	looped_predictor(void) : inner_update(0), info(), overrides(0), overrides_correct(0) {}
+
+	void print_budget(FILE *f)
+	{
+		inner.print_budget(f);
+		::print_budget(f, "loop predictor", loop_type::BUDGET);
+		print_budget_total(f, TOTAL_BUDGET_BITS, "with loop predictor");
+	}
+
+	void report(FILE *f, bool detailed)
+	{
+		inner.report(f, detailed);
+		fprintf(f, "Loop predictor statistics\n");
+		fprintf(f, "  predictions provided            %lld (%lld correct)\n", loop.provided, loop.correct);
+		fprintf(f, "  changed the engine's direction  %lld (%lld correct)\n", overrides, overrides_correct);
+	}
+
+	branch_update *predict(branch_info &b)
+	{
+		bi = b;
+		inner_update = inner.predict(b);
+		u.direction_prediction(inner_update->direction_prediction());
+		u.target_prediction(inner_update->target_prediction());
+		if (b.br_flags & BR_CONDITIONAL)
+		{
+			loop.predict(b.address, info);
+			u.direction_prediction(loop.choose(info, inner_update->direction_prediction()));
+		}
+		return &u;
+	}
+
+	void update(branch_update *, bool taken, unsigned int target)
+	{
+		if (bi.br_flags & BR_CONDITIONAL)
+		{
+			bool other = inner_update->direction_prediction();
+			if (u.direction_prediction() != other)
+			{
+				overrides++;
+				overrides_correct += u.direction_prediction() == taken;
+			}
+			loop.update(bi.address, info, taken, other, u.direction_prediction() != taken);
+		}
+		inner.update(inner_update, taken, target);
+	}
+};
+
+#endif
@@ -6,12 +6,24 @@
 #include <cstddef>
 #include <cstring>
 
+#include "../access_counter.h"
+#include "../bias_filter.h"
+#include "../budget.h"
+#include "../folded_history.h"
+#include "../training_threshold.h"
+
 #define H 64		 //NUmber of weight tables or pipeline stages
 #define NUM_WTS 8192 //Number of weights per table
-#define MASK 0x000003FF
 #define MASK_BITS 10
+#define HIST_LEN ((H - 1) * MASK_BITS) //History bits read; table i's segment starts at bit ((i - 1) * MASK_BITS) % HIST_LEN.
+			 //Only worth it under the training threshold: 32 -> 630 bits takes eon 1.07 -> 0.37
+			 //(untrained 3.10 -> 7.25)
 #define MAX_WEIGHT 127
 #define MIN_WEIGHT -128
+#define THETA_MODE THETA_ADAPTIVE // see training_threshold.h
+#define BIAS_FILTER_ENTRIES 0 // bias-free filtering, see bias_filter.h; 0 disables
+// (off: with the long history it costs mean direction MPKI on 8 traces 1.15 -> 1.22
+// at 4096 states, worse on 7, e.g. eon 0.37 -> 0.50)
 #define TARGET_BITS 15
 
 class my_update : public branch_update
@@ -19,50 +31,96 @@ class my_update : public branch_update
   public:
 	unsigned int weight_index[H];
 	int perceptron_output;
+	bool filtered; // predicted by the bias filter
 
 	my_update(void)
 	{
 		memset(weight_index, 0, sizeof(weight_index));
 		perceptron_output = 0;
+		filtered = false;
 	}
 };
 
 class my_predictor : public branch_predictor
 {
   public:
-	static const unsigned int theta = 1.93 * H + 14;
+	static const unsigned int THETA = 1.93 * H + 14; // initial value if adaptive
 	my_update u;
 	branch_info bi;
 
-	unsigned int history;
-	unsigned int path;
+	history_buffer<HIST_LEN> history;
+	unsigned int path; // low address bits of the last branch
 
 	char weight_tables[H][NUM_WTS];
 	unsigned int targets[1 << TARGET_BITS];
-
-	my_predictor(void) : history(0), path(0)
+	typedef training_threshold<(THETA_MODE == THETA_PER_TABLE) ? H : 1, THETA_MODE != THETA_FIXED> threshold_type;
+	threshold_type threshold;
+	bias_filter<BIAS_FILTER_ENTRIES> filter;
+	long long predictions;
+	access_counter weight_accesses, btb_accesses, ghr_accesses;
+
+	// Storage budget
+	static constexpr budget_component BUDGET[] = {
+		{"GHR", 1, HIST_LEN},
+		{"Path register", 1, 5},
+		{"Weight tables", H * NUM_WTS, 8},
+		{"BTB", 1 << TARGET_BITS, 32},
+		{"Adaptive thresholds (theta + counter)", threshold_type::ENTRIES, threshold_type::ENTRY_BITS},
+		{"Bias filter states", BIAS_FILTER_ENTRIES, 2},
+	};
+	static_assert(budget_bits(BUDGET) <= BUDGET_LIMIT_BITS, "mi_PsG_X exceeds BUDGET_LIMIT_KB");
+
+	my_predictor(void)
+		: path(0), threshold(THETA), filter("mi_PsG_X bias filter"), predictions(0),
+		  weight_accesses("mi_PsG_X weight tables", NUM_WTS * 8), btb_accesses("mi_PsG_X BTB", 32 << TARGET_BITS),
+		  ghr_accesses("mi_PsG_X GHR and path", HIST_LEN + 5)
 	{
 		memset(weight_tables, 0, sizeof(weight_tables));
 		memset(targets, 0, sizeof(targets));
 	}
 
+	void print_budget(FILE *f)
+	{
+		::print_budget(f, "mi_PsG_X", BUDGET);
+	}
+
+	void report(FILE *f, bool)
+	{
+		fprintf(f, "Perceptron statistics\n");
+		threshold.report(f, predictions);
+		filter.report(f);
+	}
+
 	branch_update *predict(branch_info &b)
 	{
 		bi = b;
-		if (b.br_flags & BR_CONDITIONAL)
+		bool biased_direction;
+		u.filtered = false;
+		if ((b.br_flags & BR_CONDITIONAL) && filter.lookup(b.address, biased_direction))
+		{
+			u.filtered = true; // always/never taken so far; no weights read
+			u.direction_prediction(biased_direction);
+			predictions++;
+		}
+		else if (b.br_flags & BR_CONDITIONAL)
 		{
 			u.weight_index[0] = ((b.address) % (NUM_WTS));
+			weight_accesses.read(H);
+			ghr_accesses.read();
 			u.perceptron_output = weight_tables[0][u.weight_index[0]];
 
 			unsigned int segment;
 			for (int i = 1; i < H; i++)
 			{
-				segment = ((history ^ path) & (MASK << (i - 1) * MASK_BITS)) >> (i - 1) * MASK_BITS;
+				int start = ((i - 1) * MASK_BITS) % HIST_LEN;
+				int bits = HIST_LEN - start < MASK_BITS ? HIST_LEN - start : MASK_BITS;
+				segment = history.window(start, bits) ^ (start < 32 ? (path >> start) & ((1u << bits) - 1) : 0);
 
 				u.weight_index[i] = ((segment) ^ (b.address << 1)) % (NUM_WTS);
 				u.perceptron_output += weight_tables[i][u.weight_index[i]];
 			}
 
+			predictions++;
 			if (u.perceptron_output >= 0)
 			{
 				u.direction_prediction(true);
@@ -79,39 +137,79 @@ class my_predictor : public branch_predictor
 		if (b.br_flags & BR_INDIRECT)
 		{
 			u.target_prediction(targets[b.address & ((1 << TARGET_BITS) - 1)]);
+			btb_accesses.read();
 		}
 		return &u;
 	}
 
 	void update(branch_update *u, bool taken, unsigned int target)
 	{
+		bool biased_direction;
+		bool biased = false;
 		if (bi.br_flags & BR_CONDITIONAL)
 		{
-			for (int i = 0; i < H; i++)
+			filter.update(bi.address, taken);
+			biased = filter.biased(bi.address, biased_direction); // stays out of the history
+		}
+
+		if ((bi.br_flags & BR_CONDITIONAL) && !((my_update *)u)->filtered)
+		{
+			my_update *mu = (my_update *)u;
+			bool mispredicted = mu->direction_prediction() != taken;
+			int magnitude = abs(mu->perceptron_output);
+			if (THETA_MODE == THETA_PER_TABLE)
+				train_per_table(mu->weight_index, mispredicted, magnitude, taken);
+			else if (threshold.train(0, mispredicted, magnitude, mispredicted))
 			{
-				char *c = &weight_tables[i][((my_update *)u)->weight_index[i]];
-				if (taken)
-				{
-					if (*c < MAX_WEIGHT)
-						(*c)++;
-				}
-				else
+				weight_accesses.write(H);
+				for (int i = 0; i < H; i++)
 				{
-					if (*c > MIN_WEIGHT)
-						(*c)--;
+					char *c = &weight_tables[i][mu->weight_index[i]];
+					if (taken)
+					{
+						if (*c < MAX_WEIGHT)
+							(*c)++;
+					}
+					else
+					{
+						if (*c > MIN_WEIGHT)
+							(*c)--;
+					}
 				}
 			}
 		}
 
-		history <<= 1;
-		history |= taken;
-
-		path = bi.address & 0xF;
-		path = path << 1;
+		if (!biased)
+		{
+			history.push(taken);
+			path = (bi.address & 0xF) << 1;
+			ghr_accesses.write();
+		}
 
 		if (bi.br_flags & BR_INDIRECT)
 		{
 			targets[bi.address & ((1 << TARGET_BITS) - 1)] = target;
+			btb_accesses.write();
+		}
+	}
+
+  private:
+	// each table trains under its own threshold, which rises when the
+	// table's weight pulled the wrong way in a misprediction
+	void train_per_table(const unsigned int *index, bool mispredicted, int magnitude, bool taken)
+	{
+		for (int i = 0; i < H; i++)
+		{
+			char *weight = &weight_tables[i][index[i]];
+			bool wrong = mispredicted && ((*weight >= 0) != taken);
+			weight_accesses.read();
+			if (!threshold.train(i, mispredicted, magnitude, wrong))
+				continue;
+			weight_accesses.write();
+			if (taken && *weight < MAX_WEIGHT)
+				(*weight)++;
+			else if (!taken && *weight > MIN_WEIGHT)
+				(*weight)--;
 		}
 	}
 };
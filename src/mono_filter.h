@@ -0,0 +1,160 @@
+// mono_filter.h
+// Author: Ankur Roy Chowdhury
+// Monomorphic indirect-branch filter placed in front of VPC. A branch is
+// allocated here the first time it is seen and is predicted from its single
+// recorded target, without running the VPC loop or training the shared
+// weight tables. The target is also written to VPC's BTB when the branch is
+// allocated, so that a branch evicted from the filter is not left without a
+// prediction. When a second target appears the entry is marked polymorphic
+// and the branch is handed over to VPC from then on, with both its targets.
+// A branch that falls out of the filter while VPC holds its targets comes
+// back polymorphic, so that it is not filtered again and then promoted over
+// the targets VPC has learned.
+
+#ifndef MONO_FILTER_H
+#define MONO_FILTER_H
+
+#include <cstring>
+
+#include "access_counter.h"
+#include "budget.h"
+
+template <unsigned int SETS, unsigned int WAYS, unsigned int TAG_BITS>
+class mono_filter
+{
+  public:
+	static const bool ENABLED = SETS > 0 && WAYS > 0;
+	static const unsigned int ENTRIES = SETS * WAYS;
+	static const unsigned int INDEX_BITS = bits_for(SETS);
+	static const unsigned int TAG_MASK = (1u << TAG_BITS) - 1;
+	static const unsigned int MAX_STABILITY = 3;
+	static const unsigned int ENTRY_BITS = 1 + 1 + TAG_BITS + 32 + 2; // valid + polymorphic + tag + target + stability
+
+	static_assert((SETS & (SETS - 1)) == 0, "filter set count must be a power of two");
+	static_assert(TAG_BITS > 0 && TAG_BITS < 32, "filter tag must be between 1 and 31 bits");
+
+	struct entry
+	{
+		bool valid;
+		bool polymorphic;	// a second target was seen; VPC owns this branch
+		unsigned int tag;	// partial tag
+		unsigned int target;	// the single target seen so far
+		unsigned int stability;	// saturating count of repeats of that target; victim choice
+	};
+
+	entry sets[ENABLED ? SETS : 1][ENABLED ? WAYS : 1];
+	mutable access_counter accesses;
+
+	mono_filter(void) : accesses("monomorphic filter", ENTRIES * ENTRY_BITS)
+	{
+		memset(sets, 0, sizeof(sets));
+	}
+
+	// true if pc is known to be monomorphic; its target is returned in 'target'
+	bool predict(unsigned int pc, unsigned int &target) const
+	{
+		if (!ENABLED)
+			return false;
+		accesses.read();
+		const entry *e = find(pc);
+		if (e == 0 || e->polymorphic)
+			return false;
+		target = e->target;
+		return true;
+	}
+
+	enum outcome
+	{
+		ALLOCATED,	// branch seen for the first time
+		MONOMORPHIC,	// branch still has a single target
+		PROMOTED,	// the branch just showed its second target
+		POLYMORPHIC	// branch belongs to VPC
+	};
+
+	// record the resolved target of pc; a branch that VPC already tracks
+	// (it was evicted from the filter after promotion) is allocated
+	// polymorphic. On promotion the target seen so far is returned in 'first'.
+	outcome update(unsigned int pc, unsigned int target, bool known_to_vpc, unsigned int &first)
+	{
+		if (!ENABLED)
+			return POLYMORPHIC;
+
+		accesses.read();
+		entry *e = find(pc);
+		if (e == 0 || !e->polymorphic)
+			accesses.write(); // allocation, stability or promotion
+		if (e == 0)
+		{
+			allocate(pc, target, known_to_vpc);
+			return known_to_vpc ? POLYMORPHIC : ALLOCATED;
+		}
+		if (e->polymorphic)
+			return POLYMORPHIC;
+		if (e->target == target)
+		{
+			if (e->stability < MAX_STABILITY)
+				e->stability++;
+			return MONOMORPHIC;
+		}
+		first = e->target;
+		e->polymorphic = true;
+		e->stability = MAX_STABILITY; // keep promoted branches resident
+		return PROMOTED;
+	}
+
+  private:
+	unsigned int set_index(unsigned int pc) const
+	{
+		return pc & (SETS - 1);
+	}
+
+	unsigned int tag(unsigned int pc) const
+	{
+		return (pc >> INDEX_BITS) & TAG_MASK;
+	}
+
+	entry *find(unsigned int pc)
+	{
+		entry *set = sets[set_index(pc)];
+		for (unsigned int w = 0; w < WAYS; w++)
+		{
+			if (set[w].valid && set[w].tag == tag(pc))
+				return &set[w];
+		}
+		return 0;
+	}
+
+	const entry *find(unsigned int pc) const
+	{
+		return const_cast<mono_filter *>(this)->find(pc);
+	}
+
+	// replace an invalid way, else the least stable one; other ways age
+	void allocate(unsigned int pc, unsigned int target, bool polymorphic)
+	{
+		entry *set = sets[set_index(pc)];
+		unsigned int victim = 0;
+		for (unsigned int w = 0; w < WAYS; w++)
+		{
+			if (!set[w].valid)
+			{
+				victim = w;
+				break;
+			}
+			if (set[w].stability < set[victim].stability)
+				victim = w;
+		}
+		for (unsigned int w = 0; w < WAYS; w++)
+		{
+			if (w != victim && set[w].stability > 0)
+				set[w].stability--;
+		}
+		set[victim].valid = true;
+		set[victim].polymorphic = polymorphic;
+		set[victim].tag = tag(pc);
+		set[victim].target = target;
+		set[victim].stability = polymorphic ? MAX_STABILITY : 0;
+	}
+};
+
+#endif
@@ -0,0 +1,100 @@
+// packed_table.h
+// Author: Ankur Roy Chowdhury
+// Bit-packed storage for predictor tables. Each table holds N counters of
+// BITS bits, packed back to back into 64-bit words, so a 5-bit weight or a
+// 3-bit LFU counter costs exactly 5 or 3 bits of simulator memory.
+
+#ifndef PACKED_TABLE_H
+#define PACKED_TABLE_H
+
+#include <cstring>
+
+template <unsigned int BITS, unsigned int N, bool SIGNED>
+class packed_table
+{
+  public:
+	static_assert(BITS > 0 && BITS <= 32, "packed_table entries must be 1 to 32 bits wide");
+
+	static const int MAX = SIGNED ? (int)((1ull << (BITS - 1)) - 1) : (int)((1ull << BITS) - 1);
+	static const int MIN = SIGNED ? -(int)(1ull << (BITS - 1)) : 0;
+	static const unsigned int WORDS = ((unsigned long long)N * BITS + 63) / 64;
+
+	packed_table(void)
+	{
+		clear();
+	}
+
+	void clear(void)
+	{
+		memset(words, 0, sizeof(words));
+	}
+
+	int get(unsigned int i) const
+	{
+		unsigned long long pos = (unsigned long long)i * BITS;
+		unsigned int w = pos >> 6, off = pos & 63;
+
+		unsigned long long raw = words[w] >> off;
+		if (off + BITS > 64) // entry straddles two words
+			raw |= words[w + 1] << (64 - off);
+		raw &= ENTRY_MASK;
+
+		if (SIGNED && (raw >> (BITS - 1)))
+			return (int)(raw | ~ENTRY_MASK); // sign extend
+		return (int)raw;
+	}
+
+	void set(unsigned int i, int v)
+	{
+		unsigned long long pos = (unsigned long long)i * BITS;
+		unsigned int w = pos >> 6, off = pos & 63;
+		unsigned long long raw = (unsigned long long)v & ENTRY_MASK;
+
+		words[w] = (words[w] & ~(ENTRY_MASK << off)) | (raw << off);
+		if (off + BITS > 64)
+		{
+			unsigned int spill = off + BITS - 64;
+			unsigned long long mask = (1ull << spill) - 1;
+			words[w + 1] = (words[w + 1] & ~mask) | (raw >> (64 - off));
+		}
+	}
+
+	// saturating update helpers; each returns the new value
+
+	int increment(unsigned int i)
+	{
+		int v = get(i);
+		if (v < MAX)
+			set(i, ++v);
+		return v;
+	}
+
+	int decrement(unsigned int i)
+	{
+		int v = get(i);
+		if (v > MIN)
+			set(i, --v);
+		return v;
+	}
+
+	int add(unsigned int i, int delta)
+	{
+		int v = get(i) + delta;
+		v = (v > MAX) ? MAX : ((v < MIN) ? MIN : v);
+		set(i, v);
+		return v;
+	}
+
+	// increment when 'up' is set, else decrement
+	int train(unsigned int i, bool up)
+	{
+		return up ? increment(i) : decrement(i);
+	}
+
+  private:
+	static const unsigned long long ENTRY_MASK = (1ull << BITS) - 1;
+
+	unsigned long long words[WORDS];
+};
+
+#endif
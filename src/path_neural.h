@@ -0,0 +1,229 @@
+// path_neural.h
+// Author: Ankur Roy Chowdhury
+// Ahead-pipelined path-based neural predictor (Jimenez, "Fast Path-Based
+// Neural Branch Prediction", MICRO-36 2003). Weight j of a prediction is
+// chosen by the branch j steps back on the path, not by the predicted
+// branch, so each weight can be added as soon as that earlier branch is
+// known. A vector of H partial sums is advanced at every branch; when a
+// branch is predicted, its sum is already complete and the prediction costs
+// one read of the bias weight and one add.
+//
+// Under VPC the sums are not ahead for virtual branches: each not-taken
+// virtual branch reads its row's H weights and adds them into the sums
+// before the next iteration can predict, so an iteration costs an advance
+// as well as a lookup. It is a reference design, not the default component.
+//
+// path_neural<C> is a direction component for vpc_predictor (see
+// my_predictor.h); direction_predictor.h turns it into a stand-alone
+// branch_predictor.
+
+#ifndef PATH_NEURAL_H
+#define PATH_NEURAL_H
+
+#include <bitset>
+#include <cstdio>
+#include <cstdlib>
+
+#include "access_counter.h"
+#include "budget.h"
+#include "cycle_cost.h"
+#include "packed_table.h"
+#include "table_telemetry.h"
+#include "training_threshold.h"
+
+template <int H_, int LOG_ROWS_, int THETA_, int WEIGHT_BITS_ = 8, int THETA_MODE_ = THETA_ADAPTIVE>
+struct path_neural_params
+{
+	static const int H = H_;			// history length: weights per prediction, excluding bias
+	static const int LOG_ROWS = LOG_ROWS_;		// log2 of weight rows (branches tracked)
+	static const int THETA = THETA_;		// training threshold (initial value if adaptive)
+	static const int WEIGHT_BITS = WEIGHT_BITS_;	// width of each weight
+	static const int THETA_MODE = THETA_MODE_;	// threshold_mode; per table means per weight column
+
+	static_assert(LOG_ROWS_ <= 16, "path rows are stored in 16 bits");
+};
+
+typedef path_neural_params<
+	32,	// H
+	10,	// LOG_ROWS: 1024 rows
+	89>	// THETA: floor(2.14 * (H + 1) + 20.58)
+	path_neural_config;
+
+template <class C>
+class path_neural
+{
+  public:
+	static const int H = C::H;
+	static const int ROWS = 1 << C::LOG_ROWS;
+	static const int THETA = C::THETA;
+	static const int WEIGHT_BITS = C::WEIGHT_BITS;
+	static const int THETA_MODE = C::THETA_MODE;
+
+	// partial sums plus the path and outcomes they were built from; a copy
+	// can be advanced with VPC's virtual branches
+	struct history_type
+	{
+		int sum[H + 1];			// sum[j]: contributions of the last j branches; sum[H] is complete
+		unsigned short path[H];		// weight rows of the last H branches, newest first
+		std::bitset<H> outcomes;	// their directions, bit 0 newest
+	};
+
+	struct info_type
+	{
+		unsigned int row;		// row of the predicted branch (bias weight)
+		int output;
+		bool prediction;
+		unsigned short path[H];		// path and outcomes the sum was built from
+		std::bitset<H> outcomes;
+	};
+
+	typedef training_threshold<(THETA_MODE == THETA_PER_TABLE) ? H + 1 : 1, THETA_MODE != THETA_FIXED> threshold_type;
+
+	packed_table<WEIGHT_BITS, ROWS * (H + 1), true> weights; // row-major; column 0 is the bias
+	history_type h;
+	threshold_type threshold;
+
+	long long predictions;
+	mutable access_counter weight_accesses;		// one per weight
+	mutable access_counter history_accesses;	// partial sums, path and history together
+	weight_telemetry<1, ROWS * (H + 1), WEIGHT_BITS> telemetry; // the weights as one table
+
+	static constexpr budget_component BUDGET[] = {
+		{"Weights", (unsigned long long)ROWS * (H + 1), WEIGHT_BITS},
+		{"Partial sums", H, WEIGHT_BITS + bits_for(H + 1)},
+		{"Path (weight rows)", H, C::LOG_ROWS},
+		{"Global history", 1, H},
+		{"Adaptive thresholds (theta + counter)", threshold_type::ENTRIES, threshold_type::ENTRY_BITS},
+	};
+	static constexpr unsigned long long INFO_BITS = C::LOG_ROWS + WEIGHT_BITS + bits_for(H + 2) + 1 + H * (C::LOG_ROWS + 1);
+	static constexpr const char *NAME = "path-based neural";
+	static const int LOOKUP_CYCLES = lookup_cycles(1, 2); // the sum is ready ahead; read and add the last weight
+	static const int ADVANCE_CYCLES = lookup_cycles(1, 2); // read a row's H weights, one add into each sum
+	static_assert(budget_bits(BUDGET) <= BUDGET_LIMIT_BITS, "path_neural exceeds BUDGET_LIMIT_KB");
+
+	path_neural(void)
+		: h(), threshold(THETA), predictions(0), weight_accesses("path-neural weights", ROWS * (H + 1) * WEIGHT_BITS),
+		  history_accesses("path-neural sums and path", H * (WEIGHT_BITS + bits_for(H + 1) + C::LOG_ROWS + 1))
+	{
+	}
+
+	const history_type &history(void) const
+	{
+		return h;
+	}
+
+	history_type indirect_history(void) const
+	{
+		return h;
+	}
+
+	void advance_virtual(history_type &v, unsigned int vpca) const
+	{
+		advance(v, vpca, false);
+	}
+
+	// the sum is ready; add the bias weight of this branch
+	bool predict(unsigned int pc, const history_type &v, info_type &info)
+	{
+		info.row = row(pc);
+		weight_accesses.read();
+		history_accesses.read();
+		info.output = v.sum[H] + weights.get(info.row * (H + 1));
+		info.prediction = info.output >= 0;
+		for (int j = 0; j < H; j++)
+			info.path[j] = v.path[j];
+		info.outcomes = v.outcomes;
+		predictions++;
+		telemetry.tick(predictions, &weights);
+		return info.prediction;
+	}
+
+	// weight j of the prediction belongs to the branch j steps back
+	void train(const info_type &info, bool taken)
+	{
+		bool mispredicted = info.prediction != taken;
+		int magnitude = abs(info.output);
+		telemetry.output(info.output, threshold.mean(), mispredicted);
+
+		if (THETA_MODE != THETA_PER_TABLE)
+		{
+			if (!threshold.train(0, mispredicted, magnitude, mispredicted))
+				return;
+			weight_accesses.write(H + 1);
+			weights.train(info.row * (H + 1), taken);
+			telemetry.touch(0, info.row * (H + 1));
+			for (int j = 1; j <= H; j++)
+			{
+				weights.train(info.path[j - 1] * (H + 1) + j, info.outcomes[j - 1] == taken);
+				telemetry.touch(0, info.path[j - 1] * (H + 1) + j);
+			}
+			return;
+		}
+
+		// one threshold per column, raised when the column's weight pulled
+		// the wrong way in a misprediction
+		for (int j = 0; j <= H; j++)
+		{
+			unsigned int i = j ? info.path[j - 1] * (H + 1) + j : info.row * (H + 1);
+			bool agree = j ? info.outcomes[j - 1] == taken : taken;
+			bool wrong = mispredicted && ((weights.get(i) >= 0) != agree);
+			weight_accesses.read();
+			if (threshold.train(j, mispredicted, magnitude, wrong))
+			{
+				weight_accesses.write();
+				weights.train(i, agree);
+				telemetry.touch(0, i);
+			}
+		}
+	}
+
+	void update_history(unsigned int pc, bool taken)
+	{
+		advance(h, pc, taken);
+	}
+
+	// no target history
+	void update_target(unsigned int, unsigned int)
+	{
+	}
+
+	void report(FILE *f, bool)
+	{
+		fprintf(f, "Path-based neural statistics\n");
+		fprintf(f, "  predictions (incl. virtual)     %lld\n", predictions);
+		threshold.report(f, predictions);
+		fprintf(f, "  weight reads per prediction     1 (+%d ahead, off the critical path except after a virtual branch)\n", H);
+		fprintf(f, "  adder depth per prediction      1 (perceptron over %d weights: %d)\n", H + 1,
+			bits_for(H + 1));
+		telemetry.report(f, &weights);
+	}
+
+  private:
+	static unsigned int row(unsigned int pc)
+	{
+		return (pc ^ (pc >> C::LOG_ROWS)) & (ROWS - 1);
+	}
+
+	// branch at pc resolved (or predicted) 'taken': it contributes column
+	// H - j + 1 of its row to the sum that becomes complete j branches later
+	void advance(history_type &v, unsigned int pc, bool taken) const
+	{
+		unsigned int r = row(pc) * (H + 1);
+		weight_accesses.read(H);
+		history_accesses.write();
+		for (int j = H; j >= 1; j--)
+		{
+			int w = weights.get(r + H - j + 1);
+			v.sum[j] = v.sum[j - 1] + (taken ? w : -w);
+		}
+		v.sum[0] = 0;
+
+		for (int j = H - 1; j > 0; j--)
+			v.path[j] = v.path[j - 1];
+		v.path[0] = row(pc);
+		v.outcomes <<= 1;
+		v.outcomes[0] = taken;
+	}
+};
+
+#endif
@@ -1,8 +1,9 @@
 // predict.cc
-// This file contains the main function.  The program accepts a single
-// parameter: the name of a trace file.  It drives the branch predictor
-// simulation by reading the trace file and feeding the traces one at a time
-// to the branch predictor.
+// This file contains the main function.  The program accepts the name of a
+// trace file, optionally preceded by -p to include per-PC breakdowns in the
+// predictor's report and -c to measure the simulator with the host's
+// performance counters.  It drives the branch predictor simulation by reading
+// the trace file and feeding the traces one at a time to the branch predictor.
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -13,6 +14,62 @@
 #include "trace.h"
 #include "predictor.h"
 #include "my_predictor.h"
+#include "access_counter.h"
+#include "branch_classes.h"
+#include "host_counters.h"
+
+// the simulated predictor; the Makefile builds variants with other engines
+
+// the indirect engines compared with VPC take their directions from VPC's
+// direction component alone, with no BTB, LFU or filter beside it
+#define DIRECTION_ONLY direction_predictor<merged_perceptron<vpc_config>, 0>
+
+#if defined(PREDICT_ITTAGE)
+#include "ittage.h"
+#include "direction_predictor.h"
+#include "split_predictor.h"
+#define PREDICTOR split_predictor<DIRECTION_ONLY, ittage_predictor<ittage_config> >
+#elif defined(PREDICT_BIT_PERCEPTRON)
+#include "bit_perceptron.h"
+#include "direction_predictor.h"
+#include "split_predictor.h"
+#define PREDICTOR split_predictor<DIRECTION_ONLY, bit_perceptron_predictor<bit_perceptron_config> >
+#elif defined(PREDICT_TAGE)
+#include "tage_sc_l.h"
+#define PREDICTOR vpc_predictor<vpc_config, tage_sc_l<tage_config> >
+#elif defined(PREDICT_PATH_NEURAL)
+#include "path_neural.h"
+#define PREDICTOR vpc_predictor<vpc_config, path_neural<path_neural_config> >
+#elif defined(PREDICT_TWO_LEVEL_BTB)
+#include "btb_hierarchy.h"
+#define PREDICTOR vpc_predictor<vpc_config, merged_perceptron<vpc_config>, vpc_two_level_btb>
+#elif defined(PREDICT_HYBRID)
+#include "sample_predictors.h"
+#include "hybrid.h"
+#ifndef HYBRID_COMPONENTS
+#define HYBRID_COMPONENTS gshare::my_predictor, global_perceptron::my_predictor
+#endif
+#define PREDICTOR hybrid_predictor<12, CHOOSE_BY_PC, HYBRID_COMPONENTS>
+#elif defined(PREDICT_TAGE_ONLY)
+#include "tage_sc_l.h"
+#include "direction_predictor.h"
+#define PREDICTOR direction_predictor<tage_sc_l<tage_config> >
+#else
+#define PREDICTOR my_predictor
+#endif
+
+// any of them with a loop predictor attached
+#ifdef WITH_LOOP
+#include "looped_predictor.h"
+#define SIMULATED looped_predictor<PREDICTOR>
+#else
+#define SIMULATED PREDICTOR
+#endif
+
+// with -c, the phases of one branch in this many are measured
+#ifndef HOST_COUNTER_PERIOD
+#define HOST_COUNTER_PERIOD 16
+#endif
 
 extern long long int trace_instructions, trace_branches;
 extern double instructions_per_branch;
@@ -26,21 +83,39 @@ void print_stats(long long int dmiss, long long int tmiss)
 int main(int argc, char *argv[])
 {
 
-	// make sure there is one parameter
+	// make sure there is one trace file, optionally preceded by -p and -c
 
-	if (argc != 2)
+	bool per_pc = false, host = false;
+	int arg = 1;
+	for (; arg < argc - 1; arg++)
 	{
-		fprintf(stderr, "Usage: %s <filename>.gz\n", argv[0]);
+		if (strcmp(argv[arg], "-p") == 0)
+			per_pc = true;
+		else if (strcmp(argv[arg], "-c") == 0)
+			host = true;
+		else
+			break;
+	}
+	if (arg != argc - 1)
+	{
+		fprintf(stderr, "Usage: %s [-p] [-c] <filename>.gz\n", argv[0]);
 		exit(1);
 	}
 
 	// open the trace file for reading
 
-	init_trace(argv[1]);
+	init_trace(argv[argc - 1]);
 
 	// initialize competitor's branch prediction code
 
-	branch_predictor *p = new my_predictor();
+	branch_predictor *p = new SIMULATED();
+	p->print_budget(stdout);
+
+	// host counters of the decode, predict and update phases
+
+	host_counters *hc = host ? new host_counters(HOST_COUNTER_PERIOD) : 0;
+	if (hc)
+		hc->start(host_counters::WHOLE_RUN);
 
 	// some statistics to keep, currently just for conditional branches
 
@@ -48,13 +123,19 @@ int main(int argc, char *argv[])
 		last_instructions = 0,
 		tmiss = 0, // number of target mispredictions
 		dmiss = 0; // number of direction mispredictions
+	branch_class_stats classes; // the same, by opcode and branch class
 
-	for (;;)
+	for (long long int n = 0;; n++)
 	{
+		bool sampled = hc && hc->sampled(n);
 
 		// get a trace
 
+		if (sampled)
+			hc->start(host_counters::DECODE);
 		trace *t = read_trace();
+		if (sampled)
+			hc->stop(host_counters::DECODE);
 
 		// NULL means end of file
 
@@ -63,6 +144,8 @@ int main(int argc, char *argv[])
 
 		// send this trace to the competitor's code for prediction
 
+		if (sampled)
+			hc->start(host_counters::PREDICT);
 		branch_update *u = p->predict(t->bi);
 
 		// collect statistics for a conditional branch trace
@@ -91,9 +174,19 @@ int main(int argc, char *argv[])
 			// 	printf("Indirect branch predicted: %d Actual: %d\n", u->target_prediction(), t->target);
 		}
 
+		if (sampled)
+			hc->stop(host_counters::PREDICT);
+
+		// driver bookkeeping, kept out of the measured phases
+		classes.record(t->bi, t->taken, t->target, u);
+
 		// update competitor's state
 
+		if (sampled)
+			hc->start(host_counters::UPDATE);
 		p->update(u, t->taken, t->target);
+		if (sampled)
+			hc->stop(host_counters::UPDATE);
 
 		if (trace_instructions - last_instructions > 100000000)
 		{
@@ -104,24 +197,10 @@ int main(int argc, char *argv[])
 
 	// done reading traces
 
+	if (hc)
+		hc->stop(host_counters::WHOLE_RUN);
 	end_trace();
 
-	//	for(int i=0;i<4096;i++){
-	//		for(int j=0;j<7;j++){
-	//			printf("%d\t",((my_predictor*)p)->weight_tables[j][i]);
-	//		}
-	//		printf("\n");
-	//	}
-
-	// printf("Targets\n");
-	// int count = 0;
-	// for (int i = 0; i < 32768; i++)
-	// {
-	// 	if (((my_predictor *)p)->targets[i] != 0)
-	// 		count++;
-	// }
-	// printf("%d\n", count);
-
 	// give final mispredictions per kilo-instruction and exit.
 	// the original CBP2 traces have exactly 100,000,000 instructions.
 	// newer traces update the trace reader with their instruction count
@@ -132,7 +211,13 @@ int main(int argc, char *argv[])
 	}
 	else
 		trace_instructions = instructions_per_branch * trace_branches;
+	p->report(stdout, per_pc);
+	print_accesses(stdout, trace_instructions);
+	classes.report(stdout, trace_instructions);
+	if (hc)
+		hc->report(stdout, trace_branches);
 	print_stats(dmiss, tmiss);
+	delete hc;
 	delete p;
 	exit(0);
 }
@@ -1,6 +1,8 @@
 // predictor.h
 // This file declares branch_update and branch_predictor classes.
 
+#include <stdio.h>
+
 class branch_update {
 	bool _direction_prediction;
 	unsigned int _target_prediction;
@@ -20,5 +22,7 @@ class branch_predictor {
 public:
 	virtual branch_update *predict (branch_info &) = 0;
 	virtual void update (branch_update *, bool, unsigned int) {}
+	virtual void print_budget (FILE *) {}
+	virtual void report (FILE *, bool) {}
 	virtual ~branch_predictor (void) {}
 };
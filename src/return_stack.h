@@ -0,0 +1,55 @@
+// return_stack.h
+// Author: Ankur Roy Chowdhury
+// Return address stack. Calls push their fall-through address and returns
+// pop it as the predicted target. The stack is circular: a call into a full
+// stack overwrites the oldest entry, and a return from an empty stack
+// predicts nothing. The traces give no instruction lengths, which the
+// hardware knows, so the stack keeps call addresses and a return counts as
+// correctly predicted when it lands within one instruction (at most
+// MAX_CALL_BYTES) after the popped call. Only the stack's depth and
+// overflows are modelled.
+
+#ifndef RETURN_STACK_H
+#define RETURN_STACK_H
+
+#include <cstring>
+
+template <int DEPTH>
+class return_stack
+{
+  public:
+	static const unsigned int MAX_CALL_BYTES = 15; // longest x86 instruction
+	static_assert(DEPTH >= 1, "the return stack needs at least one entry");
+
+	return_stack(void) : top(0), count(0)
+	{
+		memset(stack, 0, sizeof(stack));
+	}
+
+	// a call at 'address'
+	void call(unsigned int address)
+	{
+		top = (top + 1) % DEPTH;
+		stack[top] = address;
+		if (count < DEPTH)
+			count++;
+	}
+
+	// a return to 'target'; whether the popped address predicted it
+	bool ret(unsigned int target)
+	{
+		if (count == 0)
+			return false;
+		unsigned int call = stack[top];
+		top = (top + DEPTH - 1) % DEPTH;
+		count--;
+		return target > call && target - call <= MAX_CALL_BYTES;
+	}
+
+  private:
+	unsigned int stack[DEPTH];
+	int top;	// index of the most recent address
+	int count;	// valid addresses, at most DEPTH
+};
+
+#endif
@@ -0,0 +1,73 @@
+// sample_predictors.h
+// Author: Ankur Roy Chowdhury
+// The stand-alone conditional predictors (gshare, global perceptron,
+// mi_PsG_X, mi_AsG_X) in one program. Each header defines a class named
+// my_predictor and configures itself with macros, so that it can replace
+// my_predictor.h in predict.cc; here each is wrapped in its own namespace
+// and its macros are undefined after it, so they can be combined, e.g. by
+// hybrid_predictor.
+
+#ifndef SAMPLE_PREDICTORS_H
+#define SAMPLE_PREDICTORS_H
+
+// everything the headers include, so that none of it lands in a namespace
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+#include "alias_tracker.h"
+#include "bias_filter.h"
+#include "budget.h"
+#include "folded_history.h"
+#include "packed_table.h"
+#include "training_threshold.h"
+
+namespace gshare
+{
+#include "gshare/gshare.h"
+}
+#undef HISTORY_LENGTH
+#undef TABLE_BITS
+
+namespace global_perceptron
+{
+#include "global_perceptron/my_predictor.h"
+}
+#undef H
+#undef NUM_WTS
+#undef TARGET_BITS
+#undef MAX_WEIGHT
+#undef MIN_WEIGHT
+#undef THETA_MODE
+#undef BIAS_FILTER_ENTRIES
+
+namespace mi_PsG_X
+{
+#include "mi_PsG_X_64_8192/mi_PsG_X_64_8192.h"
+}
+#undef H
+#undef NUM_WTS
+#undef MASK_BITS
+#undef HIST_LEN
+#undef MAX_WEIGHT
+#undef MIN_WEIGHT
+#undef TARGET_BITS
+#undef THETA_MODE
+#undef BIAS_FILTER_ENTRIES
+
+namespace mi_AsG_X
+{
+#include "mi_PsG_X_64_8192/mi_AsG_X_64_8192.h"
+}
+#undef H
+#undef NUM_WTS
+#undef HIST_PER_WT
+#undef HIST_LEN
+#undef TARGET_BITS
+#undef MAX_WEIGHT
+#undef MIN_WEIGHT
+#undef THETA_MODE
+#undef BIAS_FILTER_ENTRIES
+
+#endif
@@ -0,0 +1,217 @@
+// smt.cc
+// Author: Ankur Roy Chowdhury
+// SMT driver: two or more traces, one per hardware thread, share one VPC
+// predictor. Their branches are interleaved one at a time, either in turn
+// (round-robin, the default) or by instruction count (-i): the next branch
+// comes from the thread that has executed the fewest instructions, so a
+// thread with few instructions per branch does not run ahead of the others.
+// Traces that do not count their instructions (CBP2) are taken to have 4
+// per branch for this.
+// With -h every thread keeps its own copy of the direction component's
+// global history, swapped in when one of its branches comes up; the weight
+// tables, BTB, LFU counters and filters stay shared either way. A finished
+// thread leaves the others running on their own.
+//
+// Each trace is also run alone on a predictor of its own. The report gives
+// every thread's direction and indirect MPKI alone and shared, the combined
+// MPKI, and the slowdown the extra mispredictions cause under a simple CPI
+// model: BASE_CPI plus MISPREDICT_PENALTY_CYCLES per misprediction.
+//
+// Usage: predict_smt [-i] [-h] <trace> <trace> ...
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <vector>
+
+#include "branch.h"
+#include "trace.h"
+#include "predictor.h"
+#include "my_predictor.h"
+#include "cycle_cost.h"
+
+// the shared predictor; a vpc_predictor, whose direction component's
+// history (dir.h) is what -h keeps per thread
+#ifndef SMT_PREDICTOR
+#define SMT_PREDICTOR my_predictor
+#endif
+
+// cycles per instruction without branch mispredictions, for the slowdown
+#ifndef BASE_CPI
+#define BASE_CPI 1.0
+#endif
+
+typedef SMT_PREDICTOR predictor_type;
+typedef predictor_type::history_type history_type;
+
+// how the threads' branches are interleaved
+enum smt_policy
+{
+	SMT_ROUND_ROBIN = 0,	// one branch from each thread in turn
+	SMT_ICOUNT = 1,		// the next branch from the thread with the fewest instructions
+};
+
+struct thread_result
+{
+	long long instructions, branches;
+	long long dmiss, tmiss;
+
+	double mpki(long long misses) const
+	{
+		return 1000.0 * misses / instructions;
+	}
+
+	// cycles per instruction under the misprediction penalty model
+	double cpi(void) const
+	{
+		return BASE_CPI + MISPREDICT_PENALTY_CYCLES * (dmiss + tmiss) / (double)instructions;
+	}
+};
+
+// instructions so far, estimated from the branches where the trace has not
+// counted them yet
+static double executed(const trace_reader *r)
+{
+	return r->branches * r->instructions_per_branch;
+}
+
+// the trace's instruction count, by the same convention as predict.cc
+static long long total_instructions(const trace_reader *r)
+{
+	if (r->instructions == 0)
+		return 100000000;
+	return r->instructions_per_branch * r->branches;
+}
+
+// predict one branch, count its mispredictions and train
+static void step(predictor_type *p, trace *t, thread_result &r)
+{
+	branch_update *u = p->predict(t->bi);
+	if (t->bi.br_flags & BR_CONDITIONAL)
+		r.dmiss += u->direction_prediction() != t->taken;
+	if (t->bi.br_flags & BR_INDIRECT)
+		r.tmiss += u->target_prediction() != t->target;
+	p->update(u, t->taken, t->target);
+	r.branches++;
+}
+
+// the trace alone on a predictor of its own
+void run_alone(char *fname, thread_result &r)
+{
+	predictor_type *p = new predictor_type();
+	trace_reader *reader = new trace_reader(fname);
+	while (trace *t = reader->read())
+		step(p, t, r);
+	r.instructions = total_instructions(reader);
+	delete reader;
+	delete p;
+}
+
+// the traces interleaved into one predictor
+void run_shared(char **fnames, int n, int policy, bool private_history, thread_result *r)
+{
+	predictor_type *p = new predictor_type();
+	std::vector<trace_reader *> readers(n);
+	std::vector<history_type> histories(n, p->dir.h);
+	for (int k = 0; k < n; k++)
+		readers[k] = new trace_reader(fnames[k]);
+
+	int live = n, turn = 0, current = -1;
+	while (live > 0)
+	{
+		// the thread whose branch comes next
+		int k = -1;
+		if (policy == SMT_ROUND_ROBIN)
+		{
+			while (!readers[turn])
+				turn = (turn + 1) % n;
+			k = turn;
+			turn = (turn + 1) % n;
+		}
+		else
+		{
+			for (int i = 0; i < n; i++)
+				if (readers[i] && (k < 0 || executed(readers[i]) < executed(readers[k])))
+					k = i;
+		}
+
+		if (private_history && k != current)
+		{
+			if (current >= 0)
+				histories[current] = p->dir.h;
+			p->dir.h = histories[k];
+			current = k;
+		}
+
+		trace *t = readers[k]->read();
+		if (!t)
+		{
+			r[k].instructions = total_instructions(readers[k]);
+			delete readers[k];
+			readers[k] = NULL;
+			live--;
+			continue;
+		}
+		step(p, t, r[k]);
+	}
+	delete p;
+}
+
+int main(int argc, char *argv[])
+{
+	int policy = SMT_ROUND_ROBIN;
+	bool private_history = false;
+	int first = 1;
+	for (; first < argc; first++)
+	{
+		if (strcmp(argv[first], "-i") == 0)
+			policy = SMT_ICOUNT;
+		else if (strcmp(argv[first], "-h") == 0)
+			private_history = true;
+		else
+			break;
+	}
+	int n = argc - first;
+	if (n < 2)
+	{
+		fprintf(stderr, "Usage: %s [-i] [-h] <trace> <trace> ...\n", argv[0]);
+		exit(1);
+	}
+
+	predictor_type *budget = new predictor_type();
+	budget->print_budget(stdout);
+	delete budget;
+
+	std::vector<thread_result> alone(n), shared(n);
+	for (int k = 0; k < n; k++)
+		run_alone(argv[first + k], alone[k]);
+	run_shared(argv + first, n, policy, private_history, &shared[0]);
+
+	printf("SMT: %d threads, %s, %s history\n", n, policy == SMT_ICOUNT ? "by instruction count" : "round-robin",
+	       private_history ? "per-thread" : "shared");
+	printf("  %-6s %12s %17s %17s %9s  %s\n", "thread", "instructions", "dir MPKI alone", "ind MPKI alone",
+	       "slowdown", "trace");
+	printf("  %-6s %12s %17s %17s %9s\n", "", "", "shared", "shared", "");
+
+	thread_result total_alone = {0, 0, 0, 0}, total_shared = {0, 0, 0, 0};
+	for (int k = 0; k < n; k++)
+	{
+		printf("  %-6d %12lld %8.3f %8.3f %8.3f %8.3f %9.4f  %s\n", k, shared[k].instructions,
+		       alone[k].mpki(alone[k].dmiss), shared[k].mpki(shared[k].dmiss), alone[k].mpki(alone[k].tmiss),
+		       shared[k].mpki(shared[k].tmiss), shared[k].cpi() / alone[k].cpi(), argv[first + k]);
+		total_alone.instructions += alone[k].instructions;
+		total_alone.dmiss += alone[k].dmiss;
+		total_alone.tmiss += alone[k].tmiss;
+		total_shared.instructions += shared[k].instructions;
+		total_shared.dmiss += shared[k].dmiss;
+		total_shared.tmiss += shared[k].tmiss;
+	}
+	printf("  %-6s %12lld %8.3f %8.3f %8.3f %8.3f %9.4f\n", "all", total_shared.instructions,
+	       total_alone.mpki(total_alone.dmiss), total_shared.mpki(total_shared.dmiss),
+	       total_alone.mpki(total_alone.tmiss), total_shared.mpki(total_shared.tmiss),
+	       total_shared.cpi() / total_alone.cpi());
+	printf("  (slowdown: CPI %0.2f + %d cycles per misprediction, shared over alone)\n", BASE_CPI,
+	       MISPREDICT_PENALTY_CYCLES);
+	return 0;
+}
@@ -0,0 +1,61 @@
+// split_predictor.h
+// Author: Ankur Roy Chowdhury
+// Runs two predictors side by side: directions come from D and indirect
+// targets from T. Both see every branch, so each keeps its own history.
+// Used to pair a direction-only predictor with each indirect engine, so the
+// engines are compared at identical direction MPKI and the budget total
+// counts the indirect engine and nothing of VPC's.
+
+#ifndef SPLIT_PREDICTOR_H
+#define SPLIT_PREDICTOR_H
+
+#include <cstdio>
+
+#include "budget.h"
+
+template <class D, class T>
+class split_predictor : public branch_predictor
+{
+  public:
+	D direction;
+	T target;
+
+	branch_update u;
+	branch_update *direction_update;
+	branch_update *target_update;
+
+	static constexpr unsigned long long TOTAL_BUDGET_BITS = predictor_budget_bits<D>(0) + predictor_budget_bits<T>(0);
+	static_assert(TOTAL_BUDGET_BITS <= BUDGET_LIMIT_BITS, "split_predictor exceeds BUDGET_LIMIT_KB");
+
+	split_predictor(void) : direction_update(0), target_update(0) {}
+
+	branch_update *predict(branch_info &b)
+	{
+		direction_update = direction.predict(b);
+		target_update = target.predict(b);
+		u.direction_prediction(direction_update->direction_prediction());
+		u.target_prediction(target_update->target_prediction());
+		return &u;
+	}
+
+	void update(branch_update *, bool taken, unsigned int t)
+	{
+		direction.update(direction_update, taken, t);
+		target.update(target_update, taken, t);
+	}
+
+	void print_budget(FILE *f)
+	{
+		direction.print_budget(f);
+		target.print_budget(f);
+		print_budget_total(f, TOTAL_BUDGET_BITS, "split");
+	}
+
+	void report(FILE *f, bool detailed)
+	{
+		direction.report(f, detailed);
+		target.report(f, detailed);
+	}
+};
+
+#endif
@@ -0,0 +1,384 @@
+// sweep.cc
+// Author: Ankur Roy Chowdhury
+// Design-space sweep driver for the VPC predictor. The parameter grid is
+// declared below (SWEEP_GRID); every point of the grid is instantiated as a
+// vpc_predictor at compile time. Each trace is simulated in its own process,
+// up to -j at a time, and every configuration is fed from a single decode of
+// the trace. The program prints a budget-vs-MPKI table with the Pareto
+// optimal configurations marked, then ranks the configurations by front-end
+// stall cycles per kilo-instruction: the prediction latency beyond one cycle
+// plus the misprediction penalty (cycle_cost.h).
+//
+// Usage: sweep [-j jobs] <trace> ...
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <type_traits>
+
+#include "branch.h"
+#include "trace.h"
+#include "predictor.h"
+#include "my_predictor.h"
+
+extern long long int trace_instructions, trace_branches;
+extern double instructions_per_branch;
+
+// compile-time grid machinery
+
+template <int... V> struct axis {};	 // values of one parameter
+template <int... P> struct point {};	 // one parameter combination
+template <class... T> struct type_list {};
+
+template <class... L> struct concat
+{
+	typedef type_list<> type;
+};
+template <class... A> struct concat<type_list<A...> >
+{
+	typedef type_list<A...> type;
+};
+template <class... A, class... B, class... R> struct concat<type_list<A...>, type_list<B...>, R...>
+{
+	typedef typename concat<type_list<A..., B...>, R...>::type type;
+};
+
+// append each value of an axis to one point
+template <class P, class A> struct append_each;
+template <int... P, int... V> struct append_each<point<P...>, axis<V...> >
+{
+	typedef type_list<point<P..., V>...> type;
+};
+
+// cartesian product of a point list with one more axis
+template <class L, class A> struct extend;
+template <class... Pts, class A> struct extend<type_list<Pts...>, A>
+{
+	typedef typename concat<typename append_each<Pts, A>::type...>::type type;
+};
+
+template <class L, class... Axes> struct product
+{
+	typedef L type;
+};
+template <class L, class A, class... Axes> struct product<L, A, Axes...>
+{
+	typedef typename product<typename extend<L, A>::type, Axes...>::type type;
+};
+
+// value i of the axes after the first eight, or 'otherwise' when the grid
+// leaves that parameter at its vpc_params default
+template <int... R> constexpr int trailing(unsigned int i, int otherwise)
+{
+	const int v[] = {R..., 0};
+	return i < sizeof...(R) ? v[i] : otherwise;
+}
+
+// grid point -> predictor configuration; a THETA of 0 means floor(1.93*H+14).
+// The values follow vpc_params' argument order, and the grid may stop after
+// any parameter from NUM_LFU_COUNTERS on.
+template <class P> struct point_config;
+template <int H, int W, int M, int T, int S, int A, int I, int L, int... R>
+struct point_config<point<H, W, M, T, S, A, I, L, R...> >
+{
+	static_assert(sizeof...(R) <= 10, "vpc_params takes 18 parameters");
+	typedef vpc_params<H, W, M, (T ? T : (int)(1.93 * H + 14)), S, A, I, L, R...> type;
+	static const int THETA_MODE = trailing<R...>(7, THETA_ADAPTIVE);
+	static const int TARGET_HIST_BITS = trailing<R...>(9, 0);
+	static const bool valid = M >= 4 && M <= 32 && I >= 1 && I <= 20 && THETA_MODE >= THETA_FIXED &&
+				  THETA_MODE <= THETA_PER_TABLE && TARGET_HIST_BITS <= 8 && TARGET_HIST_BITS <= M;
+};
+
+// drop points that cannot be built (history segments narrower than a path
+// entry or wider than a word, more VPC iterations than hashes, target
+// history segments wider than the history ones)
+template <class L> struct keep_valid;
+template <class... Pts> struct keep_valid<type_list<Pts...> >
+{
+	typedef typename concat<typename std::conditional<point_config<Pts>::valid,
+							   type_list<Pts>, type_list<> >::type...>::type type;
+};
+
+template <class... Axes> struct grid
+{
+	typedef typename keep_valid<typename product<type_list<point<> >, Axes...>::type>::type type;
+};
+
+//////////////////////////////////////////////////////////////////////////
+//                                                                      //
+//                          Sweep grid                                  //
+//                                                                      //
+//////////////////////////////////////////////////////////////////////////
+
+typedef grid<
+	axis<4, 6>,		// H
+	axis<2048, 4096>,	// NUM_WTS
+	axis<10>,		// MASK_BITS
+	axis<0>,		// THETA (0: floor(1.93*H+14))
+	axis<512, 1024>,	// BTB_SETS
+	axis<4>,		// BTB_WAYS
+	axis<12, 20>,		// MAX_VPC_ITERS
+	axis<1640>,		// NUM_LFU_COUNTERS
+	axis<8>,		// WEIGHT_BITS
+	axis<7>,		// LFU_BITS
+	axis<8>,		// BTB_TAG_BITS
+	axis<64>,		// MONO_FILTER_SETS (0: no filter)
+	axis<4>,		// MONO_FILTER_WAYS
+	axis<65536>,		// LFU_AGING_PERIOD (0: never)
+	axis<1>,		// ORDERED_PLACEMENT
+	axis<THETA_ADAPTIVE>,	// THETA_MODE
+	axis<4096>,		// BIAS_FILTER_ENTRIES (0: no bias filter)
+	axis<0> >		// TARGET_HIST_BITS
+	::type SWEEP_GRID;
+
+// per-configuration instantiation
+
+struct config_info
+{
+	char name[96];
+	unsigned long long budget_bits;
+};
+
+template <class L> struct configs;
+template <class... Pts> struct configs<type_list<Pts...> >
+{
+	static const unsigned int N = sizeof...(Pts);
+
+	static void create(branch_predictor **p)
+	{
+		unsigned int i = 0;
+		int expand[] = {0, ((p[i++] = new vpc_predictor<typename point_config<Pts>::type>()), 0)...};
+		(void)expand;
+	}
+
+	static void describe(config_info *c)
+	{
+		unsigned int i = 0;
+		int expand[] = {0, (point_config<Pts>::type::name(c[i].name, sizeof(c[i].name)),
+				    c[i].budget_bits = vpc_predictor<typename point_config<Pts>::type>::TOTAL_BUDGET_BITS,
+				    i++, 0)...};
+		(void)expand;
+	}
+
+	// modeled prediction latency of each configuration after a run
+	template <class R>
+	static void collect(branch_predictor **p, R *r)
+	{
+		unsigned int i = 0;
+		int expand[] = {0, (latency(static_cast<vpc_predictor<typename point_config<Pts>::type> *>(p[i]), r, i), i++, 0)...};
+		(void)expand;
+	}
+
+  private:
+	template <class P, class R>
+	static void latency(P *p, R *r, unsigned int k)
+	{
+		auto all = p->conditional_latency;
+		all.add(p->indirect_latency);
+		r->predictions[k] = all.predictions;
+		r->cycles[k] = all.cycles;
+		r->bubbles[k] = all.bubbles();
+		r->indirect_p99[k] = p->indirect_latency.percentile(0.99);
+	}
+};
+
+typedef configs<SWEEP_GRID> sweep_configs;
+static const unsigned int NUM_CONFIGS = sweep_configs::N;
+
+// results shared between the simulating processes and the parent
+
+struct trace_result
+{
+	bool done;
+	long long instructions;
+	long long dmiss[NUM_CONFIGS];
+	long long tmiss[NUM_CONFIGS];
+	long long predictions[NUM_CONFIGS];	// conditional and indirect predictions
+	long long cycles[NUM_CONFIGS];		// their modeled latency
+	long long bubbles[NUM_CONFIGS];		// latency beyond one cycle per prediction
+	int indirect_p99[NUM_CONFIGS];		// 99th percentile indirect prediction latency
+};
+
+// run every configuration on one trace; same accounting as predict.cc
+void simulate(char *fname, trace_result *r)
+{
+	branch_predictor *p[NUM_CONFIGS];
+	sweep_configs::create(p);
+
+	init_trace(fname);
+	for (;;)
+	{
+		trace *t = read_trace();
+		if (!t)
+			break;
+
+		for (unsigned int k = 0; k < NUM_CONFIGS; k++)
+		{
+			branch_update *u = p[k]->predict(t->bi);
+			if (t->bi.br_flags & BR_CONDITIONAL)
+				r->dmiss[k] += u->direction_prediction() != t->taken;
+			if (t->bi.br_flags & BR_INDIRECT)
+				r->tmiss[k] += u->target_prediction() != t->target;
+			p[k]->update(u, t->taken, t->target);
+		}
+	}
+	end_trace();
+	sweep_configs::collect(p, r);
+
+	if (trace_instructions == 0)
+		r->instructions = 100000000;
+	else
+		r->instructions = instructions_per_branch * trace_branches;
+	r->done = true;
+
+	for (unsigned int k = 0; k < NUM_CONFIGS; k++)
+		delete p[k];
+}
+
+int main(int argc, char *argv[])
+{
+	long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	int first = 1;
+	if (argc > 2 && strcmp(argv[1], "-j") == 0)
+	{
+		jobs = atoi(argv[2]);
+		first = 3;
+	}
+	if (first >= argc || jobs < 1)
+	{
+		fprintf(stderr, "Usage: %s [-j jobs] <trace> ...\n", argv[0]);
+		exit(1);
+	}
+
+	int num_traces = argc - first;
+	trace_result *results = (trace_result *)mmap(NULL, num_traces * sizeof(trace_result), PROT_READ | PROT_WRITE,
+						     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (results == MAP_FAILED)
+	{
+		perror("mmap");
+		exit(1);
+	}
+	memset(results, 0, num_traces * sizeof(trace_result));
+
+	fprintf(stderr, "%u configurations x %d traces, %ld jobs\n", NUM_CONFIGS, num_traces, jobs);
+
+	// one process per trace, at most 'jobs' at a time
+	int running = 0;
+	for (int i = 0; i < num_traces || running > 0;)
+	{
+		if (i < num_traces && running < jobs)
+		{
+			fflush(NULL);
+			pid_t pid = fork();
+			if (pid < 0)
+			{
+				perror("fork");
+				exit(1);
+			}
+			if (pid == 0)
+			{
+				simulate(argv[first + i], &results[i]);
+				_exit(0);
+			}
+			running++;
+			i++;
+		}
+		else
+		{
+			wait(NULL);
+			running--;
+		}
+	}
+
+	// average MPKI over the traces that completed
+	config_info info[NUM_CONFIGS];
+	sweep_configs::describe(info);
+
+	double dmpki[NUM_CONFIGS] = {0}, impki[NUM_CONFIGS] = {0};
+	double cycles[NUM_CONFIGS] = {0}, p99[NUM_CONFIGS] = {0}, stalls[NUM_CONFIGS] = {0};
+	int n = 0;
+	for (int i = 0; i < num_traces; i++)
+	{
+		if (!results[i].done)
+		{
+			fprintf(stderr, "%s: simulation failed; excluded from the averages\n", argv[first + i]);
+			continue;
+		}
+		for (unsigned int k = 0; k < NUM_CONFIGS; k++)
+		{
+			dmpki[k] += 1000.0 * results[i].dmiss[k] / results[i].instructions;
+			impki[k] += 1000.0 * results[i].tmiss[k] / results[i].instructions;
+			cycles[k] += results[i].cycles[k] / (double)results[i].predictions[k];
+			p99[k] += results[i].indirect_p99[k];
+			stalls[k] += 1000.0 *
+				     (results[i].bubbles[k] +
+				      MISPREDICT_PENALTY_CYCLES * (results[i].dmiss[k] + results[i].tmiss[k])) /
+				     results[i].instructions;
+		}
+		n++;
+	}
+	if (n == 0)
+		exit(1);
+
+	// sort by budget, then MPKI; a configuration is Pareto optimal when no
+	// cheaper configuration reaches its total MPKI
+	unsigned int order[NUM_CONFIGS];
+	for (unsigned int k = 0; k < NUM_CONFIGS; k++)
+		order[k] = k;
+	for (unsigned int a = 1; a < NUM_CONFIGS; a++)
+	{
+		for (unsigned int b = a; b > 0; b--)
+		{
+			unsigned int x = order[b - 1], y = order[b];
+			if (info[x].budget_bits < info[y].budget_bits ||
+			    (info[x].budget_bits == info[y].budget_bits && dmpki[x] + impki[x] <= dmpki[y] + impki[y]))
+				break;
+			order[b - 1] = y;
+			order[b] = x;
+		}
+	}
+
+	// the name column is as wide as the longest configuration name
+	int width = strlen("configuration");
+	for (unsigned int k = 0; k < NUM_CONFIGS; k++)
+		if ((int)strlen(info[k].name) > width)
+			width = strlen(info[k].name);
+
+	printf("%-*s %10s %10s %10s %10s %10s %10s %s\n", width, "configuration", "budget kB", "dir MPKI", "ind MPKI", "MPKI",
+	       "cyc/pred", "ind P99", "pareto");
+	double best = -1;
+	for (unsigned int j = 0; j < NUM_CONFIGS; j++)
+	{
+		unsigned int k = order[j];
+		double d = dmpki[k] / n, t = impki[k] / n;
+		bool pareto = best < 0 || d + t < best;
+		if (pareto)
+			best = d + t;
+		printf("%-*s %10.2f %10.3f %10.3f %10.3f %10.3f %10.1f %s\n", width, info[k].name, info[k].budget_bits / 8192.0, d, t,
+		       d + t, cycles[k] / n, p99[k] / n, pareto ? "*" : "");
+	}
+
+	// by front-end stall cycles per kilo-instruction, fewest first
+	for (unsigned int a = 1; a < NUM_CONFIGS; a++)
+	{
+		for (unsigned int b = a; b > 0 && stalls[order[b - 1]] > stalls[order[b]]; b--)
+		{
+			unsigned int x = order[b - 1];
+			order[b - 1] = order[b];
+			order[b] = x;
+		}
+	}
+
+	printf("\nfront-end stall cycles per kilo-instruction (latency bubbles + %d per misprediction)\n",
+	       MISPREDICT_PENALTY_CYCLES);
+	printf("%4s %-*s %10s\n", "rank", width, "configuration", "stalls/KI");
+	for (unsigned int j = 0; j < NUM_CONFIGS; j++)
+		printf("%4u %-*s %10.2f\n", j + 1, width, info[order[j]].name, stalls[order[j]] / n);
+
+	munmap(results, num_traces * sizeof(trace_result));
+	exit(0);
+}
@@ -0,0 +1,306 @@
+// table_telemetry.h
+// Author: Ankur Roy Chowdhury
+// Utilization telemetry of the predictors' tables, to see whether a table is
+// saturated, underused or shared by too many branches before paying for a
+// size sweep. weight_telemetry follows a set of weight tables: which entries
+// have ever been trained, how many weights sit at MAX_WEIGHT or MIN_WEIGHT,
+// the distribution of weight magnitudes, and the distribution of perceptron
+// outputs relative to the training threshold with the misprediction rate of
+// each bucket. Every TELEMETRY_PERIOD predictions it takes a snapshot of the
+// tables, so the report shows how they fill up over the run.
+// utilization_series keeps such snapshots for any other structure, e.g. the
+// BTB's occupancy.
+//
+// Magnitudes are bucketed by bit length (0, 1, 2-3, 4-7, ...), which suits
+// both weights and LFU counters. With TABLE_TELEMETRY 0 the classes are
+// empty and every call compiles away; the sweep is built that way.
+
+#ifndef TABLE_TELEMETRY_H
+#define TABLE_TELEMETRY_H
+
+#include <bitset>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "budget.h"
+
+// Telemetry switch and snapshot period; override with
+// e.g. make CXXFLAGS="-O3 -DTELEMETRY_PERIOD=1000000"
+#ifndef TABLE_TELEMETRY
+#define TABLE_TELEMETRY 1
+#endif
+#ifndef TELEMETRY_PERIOD
+#define TELEMETRY_PERIOD 1000000	// predictions (or branches) between snapshots
+#endif
+
+// values counted by bit length: bucket b holds 2^(b-1) <= v < 2^b, bucket 0 holds 0
+template <int BITS>
+class magnitude_histogram
+{
+  public:
+	static const int BUCKETS = BITS + 1;
+
+	long long count[BUCKETS];
+	long long total;
+
+	magnitude_histogram(void) : total(0)
+	{
+		memset(count, 0, sizeof(count));
+	}
+
+	void add(unsigned int v)
+	{
+		count[bits_for(v + 1)]++;
+		total++;
+	}
+
+	// column headings, one per bucket, each 'width' wide
+	static void print_header(FILE *f, int width)
+	{
+		char label[16];
+		for (int b = 0; b < BUCKETS; b++)
+		{
+			if (b < 2)
+				snprintf(label, sizeof(label), "%d", b);
+			else
+				snprintf(label, sizeof(label), "%u-%u", 1u << (b - 1), (1u << b) - 1);
+			fprintf(f, " %*s", width, label);
+		}
+	}
+
+	// the fraction of values in each bucket
+	void print(FILE *f, int width) const
+	{
+		for (int b = 0; b < BUCKETS; b++)
+			fprintf(f, " %*.3f", width, total ? count[b] / (double)total : 0.0);
+	}
+};
+
+#if TABLE_TELEMETRY
+
+// fractions of a structure at successive points of the run
+template <int VALUES>
+class utilization_series
+{
+  public:
+	struct sample
+	{
+		long long when;
+		double value[VALUES];
+	};
+
+	std::vector<sample> samples;
+
+	// record 'values' if 'when' is a multiple of TELEMETRY_PERIOD
+	bool due(long long when) const
+	{
+		return when > 0 && when % TELEMETRY_PERIOD == 0;
+	}
+
+	void record(long long when, const double *values)
+	{
+		sample s;
+		s.when = when;
+		for (int v = 0; v < VALUES; v++)
+			s.value[v] = values[v];
+		samples.push_back(s);
+	}
+
+	// 'unit' names what 'when' counts; 'names' heads the value columns
+	void print(FILE *f, const char *unit, const char *const *names) const
+	{
+		if (samples.empty())
+			return;
+		fprintf(f, "  %-16s", unit);
+		for (int v = 0; v < VALUES; v++)
+			fprintf(f, " %10s", names[v]);
+		fprintf(f, "\n");
+		for (size_t i = 0; i < samples.size(); i++)
+		{
+			fprintf(f, "  %-16lld", samples[i].when);
+			for (int v = 0; v < VALUES; v++)
+				fprintf(f, " %10.3f", samples[i].value[v]);
+			fprintf(f, "\n");
+		}
+	}
+};
+
+// TABLES weight tables of N entries of BITS bits each
+template <int TABLES, unsigned int N, int BITS>
+class weight_telemetry
+{
+  public:
+	static const int OUTPUT_BUCKETS = 8;	// |output| in steps of theta / 2; the last is 3.5 theta and up
+
+	weight_telemetry(void)
+	{
+		memset(outputs, 0, sizeof(outputs));
+		memset(output_misses, 0, sizeof(output_misses));
+	}
+
+	// entry i of table t was trained
+	void touch(int t, unsigned int i)
+	{
+		touched[t][i] = true;
+	}
+
+	// a resolved prediction's output, the threshold it was held to and its outcome
+	void output(int y, int theta, bool mispredicted)
+	{
+		int b = theta > 0 ? 2 * abs(y) / theta : OUTPUT_BUCKETS - 1;
+		if (b >= OUTPUT_BUCKETS)
+			b = OUTPUT_BUCKETS - 1;
+		outputs[b]++;
+		output_misses[b] += mispredicted;
+	}
+
+	// snapshot the tables if 'predictions' is a multiple of TELEMETRY_PERIOD
+	template <class T>
+	void tick(long long predictions, const T *tables)
+	{
+		if (!series.due(predictions))
+			return;
+		table_stats total = totals(tables);
+		double values[3] = {total.touched, total.at_max + total.at_min, total.magnitude};
+		series.record(predictions, values);
+	}
+
+	template <class T>
+	void report(FILE *f, const T *tables) const
+	{
+		fprintf(f, "Weight table utilization (trained = written at least once)\n");
+		fprintf(f, "  %-8s %8s %8s %8s %8s  |w|:", "table", "trained", "at max", "at min", "mean |w|");
+		magnitude_histogram<BITS>::print_header(f, 6);
+		fprintf(f, "\n");
+		for (int t = 0; t < TABLES; t++)
+		{
+			table_stats s = scan(tables[t], t);
+			fprintf(f, "  %-8d %8.3f %8.3f %8.3f %8.2f      ", t, s.touched, s.at_max, s.at_min, s.magnitude);
+			s.histogram.print(f, 6);
+			fprintf(f, "\n");
+		}
+
+		long long resolved = 0;
+		for (int b = 0; b < OUTPUT_BUCKETS; b++)
+			resolved += outputs[b];
+		if (resolved)
+		{
+			fprintf(f, "  |output| / theta               ");
+			for (int b = 0; b < OUTPUT_BUCKETS; b++)
+				fprintf(f, " %6s", output_label(b));
+			fprintf(f, "\n  fraction of predictions        ");
+			for (int b = 0; b < OUTPUT_BUCKETS; b++)
+				fprintf(f, " %6.3f", outputs[b] / (double)resolved);
+			fprintf(f, "\n  mispredicted                   ");
+			for (int b = 0; b < OUTPUT_BUCKETS; b++)
+				fprintf(f, " %6.3f", outputs[b] ? output_misses[b] / (double)outputs[b] : 0.0);
+			fprintf(f, "\n");
+		}
+
+		static const char *const names[3] = {"trained", "saturated", "mean |w|"};
+		series.print(f, "predictions", names);
+	}
+
+  private:
+	struct table_stats
+	{
+		double touched, at_max, at_min, magnitude;
+		magnitude_histogram<BITS> histogram;
+	};
+
+	std::bitset<N> touched[TABLES];
+	long long outputs[OUTPUT_BUCKETS];
+	long long output_misses[OUTPUT_BUCKETS];
+	utilization_series<3> series;	// trained and saturated fractions, mean |w|
+
+	template <class T>
+	table_stats scan(const T &table, int t) const
+	{
+		table_stats s;
+		long long at_max = 0, at_min = 0, magnitude = 0;
+		for (unsigned int i = 0; i < N; i++)
+		{
+			int w = table.get(i);
+			at_max += w == T::MAX;
+			at_min += w == T::MIN;
+			magnitude += abs(w);
+			s.histogram.add(abs(w));
+		}
+		s.touched = touched[t].count() / (double)N;
+		s.at_max = at_max / (double)N;
+		s.at_min = at_min / (double)N;
+		s.magnitude = magnitude / (double)N;
+		return s;
+	}
+
+	template <class T>
+	table_stats totals(const T *tables) const
+	{
+		table_stats total;
+		total.touched = total.at_max = total.at_min = total.magnitude = 0;
+		for (int t = 0; t < TABLES; t++)
+		{
+			table_stats s = scan(tables[t], t);
+			total.touched += s.touched / TABLES;
+			total.at_max += s.at_max / TABLES;
+			total.at_min += s.at_min / TABLES;
+			total.magnitude += s.magnitude / TABLES;
+		}
+		return total;
+	}
+
+	static const char *output_label(int b)
+	{
+		static const char *const labels[OUTPUT_BUCKETS] = {"<0.5", "<1", "<1.5", "<2", "<2.5", "<3", "<3.5", ">=3.5"};
+		return labels[b];
+	}
+};
+
+#else
+
+template <int VALUES>
+class utilization_series
+{
+  public:
+	bool due(long long) const
+	{
+		return false;
+	}
+
+	void record(long long, const double *)
+	{
+	}
+
+	void print(FILE *, const char *, const char *const *) const
+	{
+	}
+};
+
+template <int TABLES, unsigned int N, int BITS>
+class weight_telemetry
+{
+  public:
+	void touch(int, unsigned int)
+	{
+	}
+
+	void output(int, int, bool)
+	{
+	}
+
+	template <class T>
+	void tick(long long, const T *)
+	{
+	}
+
+	template <class T>
+	void report(FILE *, const T *) const
+	{
+	}
+};
+
+#endif
+
+#endif
@@ -0,0 +1,474 @@
+// tage_sc_l.h
+// Author: Ankur Roy Chowdhury
+// TAGE-SC-L conditional branch predictor (Seznec, "TAGE-SC-L branch
+// predictors", CBP-4 2014). A bimodal base table is backed by NUM_TABLES
+// partially tagged tables indexed with geometrically increasing global
+// history lengths; the longest matching table provides the prediction. A
+// loop predictor overrides it for counted loops, and a statistical corrector
+// (a small GEHL summing bias and history-indexed counters) reverts it when
+// TAGE is statistically wrong.
+//
+// tage_sc_l<C> is a direction component for vpc_predictor (see
+// my_predictor.h); direction_predictor.h turns it into a stand-alone
+// branch_predictor. All indices come from folded histories, so the history
+// update costs a fixed number of shifts and XORs per branch.
+
+#ifndef TAGE_SC_L_H
+#define TAGE_SC_L_H
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "budget.h"
+#include "cycle_cost.h"
+#include "folded_history.h"
+#include "loop_predictor.h"
+#include "packed_table.h"
+
+template <int LOG_BIMODAL_, int LOG_TABLE_, int NUM_TABLES_, int MIN_HIST_, int MAX_HIST_, int TAG_BITS_,
+	  int LOG_SC_, int LOG_LOOP_SETS_, int LOOP_WAYS_>
+struct tage_params
+{
+	static const int LOG_BIMODAL = LOG_BIMODAL_;	// log2 of bimodal entries
+	static const int LOG_TABLE = LOG_TABLE_;	// log2 of entries per tagged table
+	static const int NUM_TABLES = NUM_TABLES_;	// number of tagged tables
+	static const int MIN_HIST = MIN_HIST_;		// history length of the first tagged table
+	static const int MAX_HIST = MAX_HIST_;		// history length of the last tagged table
+	static const int TAG_BITS = TAG_BITS_;		// partial tag width
+	static const int LOG_SC = LOG_SC_;		// log2 of entries per statistical corrector table
+	static const int LOG_LOOP_SETS = LOG_LOOP_SETS_; // log2 of loop predictor sets
+	static const int LOOP_WAYS = LOOP_WAYS_;	// loop predictor associativity
+
+	static_assert(NUM_TABLES_ >= 2 && NUM_TABLES_ <= 32, "TAGE needs 2 to 32 tagged tables");
+	static_assert(MIN_HIST_ < MAX_HIST_ && MAX_HIST_ < 2048, "history lengths must grow and fit the history buffer");
+};
+
+typedef tage_params<
+	13,	// LOG_BIMODAL: 8K-entry bimodal table
+	10,	// LOG_TABLE: 1K entries per tagged table
+	12,	// NUM_TABLES
+	4,	// MIN_HIST
+	640,	// MAX_HIST
+	11,	// TAG_BITS
+	10,	// LOG_SC: 1K counters per corrector table
+	4,	// LOG_LOOP_SETS: 16 sets
+	4>	// LOOP_WAYS
+	tage_config;
+
+template <class C>
+class tage_sc_l
+{
+  public:
+	static const int LOG_BIMODAL = C::LOG_BIMODAL;
+	static const int LOG_TABLE = C::LOG_TABLE;
+	static const int NUM_TABLES = C::NUM_TABLES;
+	static const int TAG_BITS = C::TAG_BITS;
+	static const int LOG_SC = C::LOG_SC;
+	static const int CTR_MAX = 3;		   // 3-bit signed prediction counters
+	static const int CTR_MIN = -4;
+	static const int U_MAX = 3;		   // 2-bit useful counters
+	static const int U_RESET_PERIOD = 1 << 18; // updates between useful-counter agings
+	static const int USE_ALT_MAX = 7;	   // 4-bit signed use-alt-on-newly-allocated counter
+	static const int USE_ALT_MIN = -8;
+	static const int NUM_SC = 4;		   // corrector tables: bias plus three history lengths
+	static const int SC_BITS = 6;
+	static const int SC_TC_LIMIT = 31;	   // threshold adaptation counter range
+
+	typedef loop_predictor<C::LOG_LOOP_SETS, C::LOOP_WAYS, 10> loop_type;
+
+	struct tagged_entry
+	{
+		bool valid;
+		unsigned short tag;
+		signed char ctr;	// prediction counter, taken when >= 0
+		unsigned char u;	// useful counter
+	};
+
+	// folded copies of the global history, taken at prediction time; VPC
+	// extends them with virtual not-taken branches without touching ghist
+	struct history_type
+	{
+		folded_history index[NUM_TABLES];
+		folded_history tag[2][NUM_TABLES];
+		folded_history sc[NUM_SC];	// sc[0] is unused: the bias table reads no history
+		unsigned int phist;		// path history: one address bit per branch
+		int virtual_bits;		// virtual branches appended to the real history
+		bool indirect;			// a virtual branch history; bypasses the loop predictor and corrector
+	};
+
+	struct info_type
+	{
+		unsigned int pc;
+		bool indirect;		// a virtual branch, predicted by TAGE alone
+		unsigned int bimodal_index;
+		unsigned int index[NUM_TABLES];
+		unsigned int tag[NUM_TABLES];
+		int provider;		// tagged table that supplied the prediction, -1 for the bimodal table
+		int alt;		// next longest match, -1 for the bimodal table
+		bool provider_pred;
+		bool alt_pred;
+		bool tage_pred;		// TAGE prediction after the use-alt choice
+		bool loop_pred;		// after the loop predictor
+		typename loop_type::info_type loop;
+		unsigned int sc_index[NUM_SC];
+		int sc_sum;
+		bool prediction;	// final prediction, after the statistical corrector
+	};
+
+	packed_table<2, 1 << LOG_BIMODAL, false> bimodal;
+	tagged_entry tables[NUM_TABLES][1 << LOG_TABLE];
+	int hist_len[NUM_TABLES];
+	int use_alt_on_na;
+
+	packed_table<SC_BITS, NUM_SC << LOG_SC, true> sc;
+	int sc_threshold;	// override and training threshold of the corrector
+	int sc_tc;		// threshold adaptation counter
+
+	loop_type loop;
+
+	history_buffer<2048> ghist;
+	history_type h;
+
+	unsigned int updates;		// updates since the last useful-counter aging
+	unsigned int alloc_seed;	// pseudo-random choice of allocation table
+	long long provider_hist[NUM_TABLES + 1]; // predictions by provider (0 = bimodal)
+	long long sc_overrides, sc_overrides_correct;
+
+	static constexpr budget_component BUDGET[] = {
+		{"Bimodal table", 1 << LOG_BIMODAL, 2},
+		{"Tagged tables (valid + tag + ctr + u)", (unsigned long long)NUM_TABLES << LOG_TABLE, 1 + TAG_BITS + 3 + 2},
+		{"Use-alt-on-NA counter", 1, 4},
+		{"Useful-counter aging counter", 1, 18},
+		{"Global history", 1, C::MAX_HIST},
+		{"Path history", 1, 16},
+		{"Folded histories (TAGE)", 3 * NUM_TABLES, LOG_TABLE},
+		{"Folded histories (SC)", NUM_SC - 1, LOG_SC},
+		{"Statistical corrector tables", NUM_SC << LOG_SC, SC_BITS},
+		{"SC threshold + adaptation counter", 1, 8 + 6},
+		{"Loop predictor entries", loop_type::ENTRIES, loop_type::ENTRY_BITS},
+		{"Loop use counter", 1, 7},
+	};
+	static constexpr unsigned long long INFO_BITS = LOG_BIMODAL + NUM_TABLES * (LOG_TABLE + TAG_BITS) +
+		2 * bits_for(NUM_TABLES + 1) + 4 + loop_type::INFO_BITS + NUM_SC * LOG_SC + 10 + 1;
+	static constexpr const char *NAME = "TAGE-SC-L";
+	// all tables read at once; then the longest matching table is selected
+	// and the corrector sums its tables
+	static const int LOOKUP_CYCLES = lookup_cycles(1, NUM_TABLES + 1) + adder_cycles(NUM_SC + 1);
+	static const int ADVANCE_CYCLES = 0; // one XOR per folded register
+	static_assert(budget_bits(BUDGET) <= BUDGET_LIMIT_BITS, "tage_sc_l exceeds BUDGET_LIMIT_KB");
+
+	tage_sc_l(void) : use_alt_on_na(0), sc_threshold(35), sc_tc(0), updates(0), alloc_seed(0),
+			  sc_overrides(0), sc_overrides_correct(0)
+	{
+		memset(tables, 0, sizeof(tables));
+		memset(provider_hist, 0, sizeof(provider_hist));
+		for (int i = 0; i < (1 << LOG_BIMODAL); i++)
+			bimodal.set(i, 2); // weakly taken
+
+		// geometric history lengths between MIN_HIST and MAX_HIST
+		for (int i = 0; i < NUM_TABLES; i++)
+		{
+			double ratio = pow((double)C::MAX_HIST / C::MIN_HIST, (double)i / (NUM_TABLES - 1));
+			hist_len[i] = (int)(C::MIN_HIST * ratio + 0.5);
+			h.index[i].init(hist_len[i], LOG_TABLE);
+			h.tag[0][i].init(hist_len[i], TAG_BITS);
+			h.tag[1][i].init(hist_len[i], TAG_BITS - 1);
+		}
+		static const int SC_HIST[NUM_SC] = {0, 8, 16, 32};
+		for (int i = 1; i < NUM_SC; i++)
+			h.sc[i].init(SC_HIST[i], LOG_SC);
+		h.phist = 0;
+		h.virtual_bits = 0;
+		h.indirect = false;
+	}
+
+	const history_type &history(void) const
+	{
+		return h;
+	}
+
+	history_type indirect_history(void) const
+	{
+		history_type v = h;
+		v.indirect = true;
+		return v;
+	}
+
+	// a virtual not-taken branch: the bit leaving each window is still in ghist,
+	// virtual_bits positions further back than for a real push
+	void advance_virtual(history_type &v, unsigned int vpca) const
+	{
+		v.virtual_bits++;
+		for (int i = 0; i < NUM_TABLES; i++)
+		{
+			v.index[i].update(false, virtual_out(v.index[i], v.virtual_bits));
+			v.tag[0][i].update(false, virtual_out(v.tag[0][i], v.virtual_bits));
+			v.tag[1][i].update(false, virtual_out(v.tag[1][i], v.virtual_bits));
+		}
+		for (int i = 1; i < NUM_SC; i++)
+			v.sc[i].update(false, virtual_out(v.sc[i], v.virtual_bits));
+		v.phist = ((v.phist << 1) ^ ((vpca >> 2) & 1)) & 0xffff;
+	}
+
+	bool predict(unsigned int pc, const history_type &v, info_type &info)
+	{
+		info.pc = pc;
+		info.indirect = v.indirect;
+		info.bimodal_index = pc & ((1 << LOG_BIMODAL) - 1);
+		for (int i = 0; i < NUM_TABLES; i++)
+		{
+			info.index[i] = table_index(pc, v, i);
+			info.tag[i] = table_tag(pc, v, i);
+		}
+
+		// longest and second longest matching tables
+		info.provider = info.alt = -1;
+		for (int i = NUM_TABLES - 1; i >= 0; i--)
+		{
+			const tagged_entry &e = tables[i][info.index[i]];
+			if (!e.valid || e.tag != info.tag[i])
+				continue;
+			if (info.provider < 0)
+				info.provider = i;
+			else
+			{
+				info.alt = i;
+				break;
+			}
+		}
+
+		info.alt_pred = (info.alt >= 0) ? tables[info.alt][info.index[info.alt]].ctr >= 0
+						: bimodal.get(info.bimodal_index) >= 2;
+		int confidence; // centered provider counter, -7..7
+		if (info.provider >= 0)
+		{
+			const tagged_entry &e = tables[info.provider][info.index[info.provider]];
+			info.provider_pred = e.ctr >= 0;
+			confidence = 2 * e.ctr + 1;
+			// a weak, likely newly allocated entry defers to the alternate prediction
+			bool weak = confidence == 1 || confidence == -1;
+			info.tage_pred = (weak && use_alt_on_na >= 0) ? info.alt_pred : info.provider_pred;
+		}
+		else
+		{
+			info.provider_pred = info.alt_pred;
+			confidence = 2 * bimodal.get(info.bimodal_index) - 3;
+			info.tage_pred = info.alt_pred;
+		}
+
+		// a virtual branch stands for one target of an indirect branch, not a
+		// loop exit, so it has no trip count for the loop predictor; it also
+		// stays out of the corrector, whose tables serve the real branches
+		if (info.indirect)
+		{
+			info.loop_pred = info.prediction = info.tage_pred;
+			return info.prediction;
+		}
+
+		loop.predict(pc, info.loop);
+		info.loop_pred = loop.choose(info.loop, info.tage_pred);
+
+		// statistical corrector: counters indexed by pc, history and the prediction so far
+		info.sc_sum = 4 * (info.loop_pred == info.tage_pred ? confidence : (info.loop_pred ? 7 : -7));
+		for (int i = 0; i < NUM_SC; i++)
+		{
+			unsigned int idx = (i == 0) ? (pc ^ (pc >> LOG_SC)) : (pc ^ (pc >> (LOG_SC - i)) ^ v.sc[i].comp);
+			idx = ((idx << 1) | info.loop_pred) & ((1 << LOG_SC) - 1);
+			info.sc_index[i] = (i << LOG_SC) | idx;
+			info.sc_sum += 2 * sc.get(info.sc_index[i]) + 1;
+		}
+		bool sc_pred = info.sc_sum >= 0;
+		info.prediction = (sc_pred != info.loop_pred && abs(info.sc_sum) >= sc_threshold) ? sc_pred : info.loop_pred;
+		return info.prediction;
+	}
+
+	void train(const info_type &info, bool taken)
+	{
+		provider_hist[info.provider + 1]++;
+		if (!info.indirect)
+		{
+			loop.update(info.pc, info.loop, taken, info.tage_pred, info.prediction != taken);
+			train_sc(info, taken);
+		}
+
+		if (info.provider >= 0)
+		{
+			tagged_entry &e = tables[info.provider][info.index[info.provider]];
+			bool weak = e.ctr == 0 || e.ctr == -1;
+
+			if (weak && info.provider_pred != info.alt_pred)
+			{
+				use_alt_on_na += (info.alt_pred == taken) ? 1 : -1;
+				use_alt_on_na = clamp(use_alt_on_na, USE_ALT_MIN, USE_ALT_MAX);
+			}
+
+			// useful when the provider was right and the alternate would have been wrong
+			if (info.provider_pred != info.alt_pred)
+			{
+				if (info.provider_pred == taken && e.u < U_MAX)
+					e.u++;
+				else if (info.provider_pred != taken && e.u > 0)
+					e.u--;
+			}
+
+			train_ctr(e.ctr, taken);
+
+			// a provider that has not proven useful also trains the alternate
+			if (e.u == 0)
+			{
+				if (info.alt >= 0)
+					train_ctr(tables[info.alt][info.index[info.alt]].ctr, taken);
+				else
+					bimodal.train(info.bimodal_index, taken);
+			}
+		}
+		else
+			bimodal.train(info.bimodal_index, taken);
+
+		if (info.tage_pred != taken && info.provider < NUM_TABLES - 1)
+			allocate(info, taken);
+
+		if (++updates >= (unsigned int)U_RESET_PERIOD)
+		{
+			for (int i = 0; i < NUM_TABLES; i++)
+				for (int j = 0; j < (1 << LOG_TABLE); j++)
+					tables[i][j].u >>= 1;
+			updates = 0;
+		}
+	}
+
+	void update_history(unsigned int pc, bool taken)
+	{
+		ghist.push(taken);
+		for (int i = 0; i < NUM_TABLES; i++)
+		{
+			h.index[i].update(ghist);
+			h.tag[0][i].update(ghist);
+			h.tag[1][i].update(ghist);
+		}
+		for (int i = 1; i < NUM_SC; i++)
+			h.sc[i].update(ghist);
+		h.phist = ((h.phist << 1) ^ ((pc >> 2) & 1)) & 0xffff;
+	}
+
+	// no target history
+	void update_target(unsigned int, unsigned int)
+	{
+	}
+
+	void report(FILE *f, bool)
+	{
+		long long n = 0;
+		for (int i = 0; i <= NUM_TABLES; i++)
+			n += provider_hist[i];
+		fprintf(f, "TAGE-SC-L statistics\n");
+		fprintf(f, "  trained predictions             %lld\n", n);
+		if (n == 0)
+			return;
+		fprintf(f, "  loop predictions used           %lld (%0.4f correct)\n", loop.provided,
+			loop.provided ? loop.correct / (double)loop.provided : 0.0);
+		fprintf(f, "  SC overrides                    %lld (%0.4f correct), threshold %d\n", sc_overrides,
+			sc_overrides ? sc_overrides_correct / (double)sc_overrides : 0.0, sc_threshold);
+		fprintf(f, "  %8s %8s %12s %8s\n", "provider", "history", "predictions", "%");
+		for (int i = 0; i <= NUM_TABLES; i++)
+		{
+			char name[8] = "bimodal";
+			if (i)
+				snprintf(name, sizeof(name), "T%d", i);
+			fprintf(f, "  %8s %8d %12lld %8.3f\n", name, i ? hist_len[i - 1] : 0, provider_hist[i],
+				100.0 * provider_hist[i] / n);
+		}
+	}
+
+  private:
+	static int clamp(int v, int lo, int hi)
+	{
+		return (v > hi) ? hi : ((v < lo) ? lo : v);
+	}
+
+	static void train_ctr(signed char &ctr, bool taken)
+	{
+		ctr = clamp(ctr + (taken ? 1 : -1), CTR_MIN, CTR_MAX);
+	}
+
+	bool virtual_out(const folded_history &f, int virtual_bits) const
+	{
+		return f.length() >= virtual_bits && ghist.bit(f.length() - virtual_bits);
+	}
+
+	unsigned int table_index(unsigned int pc, const history_type &v, int i) const
+	{
+		unsigned int path = v.phist & ((1u << (hist_len[i] < 16 ? hist_len[i] : 16)) - 1);
+		unsigned int idx = pc ^ (pc >> (LOG_TABLE - (i % LOG_TABLE))) ^ v.index[i].comp ^ path ^ (path >> LOG_TABLE);
+		return idx & ((1 << LOG_TABLE) - 1);
+	}
+
+	unsigned int table_tag(unsigned int pc, const history_type &v, int i) const
+	{
+		return (pc ^ v.tag[0][i].comp ^ (v.tag[1][i].comp << 1)) & ((1 << TAG_BITS) - 1);
+	}
+
+	// GEHL-style training with an adaptive threshold: mispredictions raise
+	// it, correct low-confidence updates lower it
+	void train_sc(const info_type &info, bool taken)
+	{
+		bool sc_pred = info.sc_sum >= 0;
+		if (info.prediction != info.loop_pred)
+		{
+			sc_overrides++;
+			sc_overrides_correct += info.prediction == taken;
+		}
+		if (sc_pred == taken && abs(info.sc_sum) >= sc_threshold)
+			return;
+
+		if (sc_pred != taken)
+			sc_tc++;
+		else
+			sc_tc--;
+		if (sc_tc > SC_TC_LIMIT)
+		{
+			sc_threshold = clamp(sc_threshold + 1, 6, 255);
+			sc_tc = 0;
+		}
+		else if (sc_tc < -SC_TC_LIMIT)
+		{
+			sc_threshold = clamp(sc_threshold - 1, 6, 255);
+			sc_tc = 0;
+		}
+
+		for (int i = 0; i < NUM_SC; i++)
+			sc.train(info.sc_index[i], taken);
+	}
+
+	// allocate one entry in a longer-history table whose useful counter is clear
+	void allocate(const info_type &info, bool taken)
+	{
+		int start = info.provider + 1;
+		alloc_seed = alloc_seed * 1103515245 + 12345;
+		if (start < NUM_TABLES - 1 && ((alloc_seed >> 16) & 1)) // skip a table now and then to spread allocations
+			start++;
+
+		for (int i = start; i < NUM_TABLES; i++)
+		{
+			tagged_entry &e = tables[i][info.index[i]];
+			if (e.u == 0)
+			{
+				e.valid = true;
+				e.tag = info.tag[i];
+				e.ctr = taken ? 0 : -1;
+				return;
+			}
+		}
+
+		// no room: age the candidates so a later allocation succeeds
+		for (int i = info.provider + 1; i < NUM_TABLES; i++)
+		{
+			if (tables[i][info.index[i]].u > 0)
+				tables[i][info.index[i]].u--;
+		}
+	}
+};
+
+#endif
@@ -42,35 +42,14 @@
 // the purpose is to allow the stream of bytes fed to gzip or bzip2 to be
 // much more redundant and hence more compressible.
 
-// number of bytes to read at once from the decompressor
-
-#define BUFSIZE	10000
+// counts of the trace read by init_trace/read_trace
 
 long long int trace_instructions, trace_branches = 0;
 double instructions_per_branch = 4.0;
 
-// file pointer for the pipe from the decompressor
-
-FILE *tracefp;
-
-// buffer to read bytes into
-
-unsigned char buf[BUFSIZE];
-
-// current position in buffer
-unsigned int bufpos;
-
-// number of bytes read into buffer
-
-unsigned int bufsize;
-
-// true when end of file is reached
-
-bool end_of_file;
-
 // read a single byte from the trace file
 
-unsigned char read_byte (void) {
+unsigned char trace_reader::read_byte (void) {
 
 	// if the buffer is empty...
 
@@ -79,7 +58,7 @@ unsigned char read_byte (void) {
 		// get a BUFSIZE-sized chunk of bytes from the input
 
 		bufpos = 0;
-		bufsize = fread (buf, 1, BUFSIZE, tracefp);
+		bufsize = fread (buf, 1, BUFSIZE, fp);
 
 		// nothing to read?  we must be done.
 
@@ -96,7 +75,7 @@ unsigned char read_byte (void) {
 
 // read an unsigned integer in little endian format from the trace file
 
-unsigned int read_uint (void) {
+unsigned int trace_reader::read_uint (void) {
 	unsigned int x0, x1, x2, x3;
 
 	x0 = read_byte ();
@@ -141,27 +120,20 @@ struct remember {
 	}
 };
 
-// a return address stack
-                                                                                
-#define RAS_SIZE        100
-                                                                                
-unsigned int ras[RAS_SIZE];
-int ras_top = RAS_SIZE;
-
 // (re)initialize the return address stack
-void init_ras (void) {
+void trace_reader::init_ras (void) {
 	ras_top = RAS_SIZE;
 }
 
 // push a target onto the return address stack
 
-void push_ras (unsigned int a) {
+void trace_reader::push_ras (unsigned int a) {
 	if (ras_top) ras[--ras_top] = a;
 }
 
 // pop a target from the return address stack
 
-unsigned int pop_ras (void) {
+unsigned int trace_reader::pop_ras (void) {
 	if (ras_top < RAS_SIZE) return ras[ras_top++];
 	return 0;
 }
@@ -171,35 +143,25 @@ unsigned int pop_ras (void) {
 #define N_REMEMBER	(1<<16)
 #define ASSOC		8
 
-// the predictor table; a 64k-entry 8-way set associative memory.
-// a hash table with probing would probably be more space-efficient
-// but I think this is a little faster (neither has good locality).
-// we can only remember up to 8 possible predictions per branch target
-// because we're squeezing set indices into a 3-bit code so having
+// the predictor table (rtab in trace_reader) is a 64k-entry 8-way set
+// associative memory.  a hash table with probing would probably be more
+// space-efficient but I think this is a little faster (neither has good
+// locality).  we can only remember up to 8 possible predictions per branch
+// target because we're squeezing set indices into a 3-bit code so having
 // a fixed set size is OK.  in practice, most branches need only 1 or 2
 // possible predictions, but some traces benefit from higher associativity.
 
-remember rtab[N_REMEMBER][ASSOC];
-
-// this int keeps time for the LRU algorithm
-
-static unsigned int now = 0; 
-
-// last trace seen
-
-static remember last_one; 
-
 // predict a trace
 
-remember *predict_remember (void) {
-	unsigned int index = last_one.target & (N_REMEMBER-1);
-	remember *r = &rtab[index][0];
+remember *trace_reader::predict_remember (void) {
+	unsigned int index = last_one->target & (N_REMEMBER-1);
+	remember *r = &rtab[index * ASSOC];
 	return r;
 }
 
 // update the predictor
 
-void update_remember (remember & me, remember *r, bool correct, int index) {
+void trace_reader::update_remember (remember & me, remember *r, bool correct, int index) {
 	if (correct) {
 		r[index].lru_time = now++;
 	} else {
@@ -210,13 +172,12 @@ void update_remember (remember & me, remember *r, bool correct, int index) {
 		r[lru] = me;
 		r[lru].lru_time = now++;
 	}
-	last_one = me;
+	*last_one = me;
 }
 
 // read a single trace from the file
 
-trace *read_trace1 (void) {
-	static trace t;
+trace *trace_reader::read1 (void) {
 	bool ras_correct, ras_offby2, ras_offby3, correct;
 
 	// read the next byte; it will either be a code, a set index for
@@ -416,19 +377,19 @@ trace *read_trace1 (void) {
 	return & t;
 }
 
-trace *read_trace (void) {
+trace *trace_reader::read (void) {
 top:
-	trace *t = read_trace1 ();
+	trace *t = read1 ();
 	if (!t) return NULL;
 
 	// see if this is a pretend branch giving an instruction count
 
 	if (t->bi.address == 0) {
-		trace_instructions += t->target;
-		instructions_per_branch = trace_instructions / (double) trace_branches;
+		instructions += t->target;
+		instructions_per_branch = instructions / (double) branches;
 		goto top;
 	}
-	trace_branches++;
+	branches++;
 	return t;
 };
 
@@ -438,14 +399,23 @@ top:
 #define BZIP2_MAGIC	"BZ"
 #define XZ_MAGIC	"\375\067"
 
-void init_trace (char *fname) {
+trace_reader::trace_reader (char *fname) {
 	const char *dc;
 	char s[2] = { 0, 0 };
 	char cmd[1000];
 
-	// no instructions so far
+	// no instructions or branches so far
 
-	trace_instructions = 0;
+	instructions = 0;
+	branches = 0;
+	instructions_per_branch = 4.0;
+
+	// empty decompression predictor and return address stack
+
+	rtab = new remember[N_REMEMBER * ASSOC];
+	last_one = new remember;
+	now = 0;
+	init_ras ();
 
 	// figure out the compression method from the magic number
 
@@ -472,10 +442,10 @@ void init_trace (char *fname) {
 
 	sprintf (cmd, "%s %s", dc, fname);
 
-	// pipe that stdout to tracefp
+	// pipe that stdout to fp
 
-	tracefp = popen (cmd, "r");
-	if (!tracefp) {
+	fp = popen (cmd, "r");
+	if (!fp) {
 		perror (fname);
 		exit (1);
 	}
@@ -486,6 +456,30 @@ void init_trace (char *fname) {
 
 // close the trace file
 
+trace_reader::~trace_reader (void) {
+	fclose (fp);
+	delete [] rtab;
+	delete last_one;
+}
+
+// the single trace of predict.cc and sweep.cc, read through a default
+// reader whose counts are kept in the globals
+
+static trace_reader *default_reader;
+
+void init_trace (char *fname) {
+	default_reader = new trace_reader (fname);
+	trace_instructions = 0;
+}
+
+trace *read_trace (void) {
+	trace *t = default_reader->read ();
+	trace_instructions = default_reader->instructions;
+	trace_branches = default_reader->branches;
+	instructions_per_branch = default_reader->instructions_per_branch;
+	return t;
+}
+
 void end_trace (void) {
-	fclose (tracefp);
+	delete default_reader;
 }
@@ -10,12 +10,59 @@
 #define XZCAT           "/usr/bin/xz -dc"
 #define CAT             "/bin/cat"
 
+#include <stdio.h>
+
 struct trace {
 	bool	taken;
 	unsigned int target;
 	branch_info bi;
 };
 
+// a trace file being read.  several can be read at once, e.g. one per
+// hardware thread by the SMT driver (smt.cc).
+
+struct remember;
+
+class trace_reader {
+public:
+	long long int instructions, branches;	// counted so far
+	double instructions_per_branch;
+
+	trace_reader (char *);
+	~trace_reader (void);
+	trace *read (void);
+
+private:
+	static const int BUFSIZE = 10000;	// bytes read at once from the decompressor
+	static const int RAS_SIZE = 100;	// return address stack of the decompression
+
+	FILE *fp;			// pipe from the decompressor
+	unsigned char buf[BUFSIZE];	// buffer to read bytes into
+	unsigned int bufpos;		// current position in buffer
+	unsigned int bufsize;		// number of bytes read into buffer
+	bool end_of_file;		// true when end of file is reached
+
+	unsigned int ras[RAS_SIZE];	// return address stack
+	int ras_top;
+
+	remember *rtab;			// decompression predictor table, N_REMEMBER x ASSOC
+	remember *last_one;		// last trace seen
+	unsigned int now;		// time for the LRU algorithm
+	trace t;			// the trace returned by read
+
+	unsigned char read_byte (void);
+	unsigned int read_uint (void);
+	void init_ras (void);
+	void push_ras (unsigned int);
+	unsigned int pop_ras (void);
+	remember *predict_remember (void);
+	void update_remember (remember &, remember *, bool, int);
+	trace *read1 (void);
+};
+
+// read one trace through a default reader, keeping its counts in
+// trace_instructions, trace_branches and instructions_per_branch
+
 void init_trace (char *);
 trace *read_trace (void);
 void end_trace (void);
@@ -0,0 +1,128 @@
+// training_threshold.h
+// Author: Ankur Roy Chowdhury
+// Perceptron training threshold, fixed or adaptive. The adaptive form is
+// Seznec's threshold fitting from O-GEHL: a small counter goes up on every
+// misprediction and down on every correct prediction that trained only
+// because its output was below the threshold. When the counter saturates
+// the threshold moves one step, so it settles where the two kinds of
+// training are about equally frequent. Training on confident correct
+// predictions is what the threshold exists to prevent, and each one is a
+// table write, so the statistics count writes as well as MPKI.
+//
+// N thresholds can be kept side by side, e.g. one per weight table; the
+// caller decides which events count against which threshold.
+
+#ifndef TRAINING_THRESHOLD_H
+#define TRAINING_THRESHOLD_H
+
+#include <cstdio>
+
+// how a perceptron predictor sets its training threshold
+enum threshold_mode
+{
+	THETA_FIXED = 0,	// constant THETA
+	THETA_ADAPTIVE = 1,	// one adaptive threshold for the predictor
+	THETA_PER_TABLE = 2,	// one adaptive threshold per weight table
+};
+
+template <int N, bool ADAPTIVE, int TC_BITS = 7>
+class training_threshold
+{
+  public:
+	static const int TC_MAX = (1 << (TC_BITS - 1)) - 1;
+	static const int TC_MIN = -(1 << (TC_BITS - 1));
+	static const int THETA_BITS = 8;	// adaptive thresholds saturate at 255
+	static const int THETA_MAX = (1 << THETA_BITS) - 1;
+
+	// storage of the thresholds and counters, for a BUDGET list
+	static const int ENTRIES = ADAPTIVE ? N : 0;
+	static const int ENTRY_BITS = THETA_BITS + TC_BITS;
+
+	long long mispredicted_trainings, low_trainings;	// trainings of each kind, summed over the thresholds
+
+	explicit training_threshold(int initial) : mispredicted_trainings(0), low_trainings(0)
+	{
+		for (int i = 0; i < N; i++)
+		{
+			theta[i] = initial;
+			tc[i] = 0;
+		}
+	}
+
+	int get(int i = 0) const
+	{
+		return theta[i];
+	}
+
+	// the thresholds' average, rounded down
+	int mean(void) const
+	{
+		int sum = 0;
+		for (int i = 0; i < N; i++)
+			sum += theta[i];
+		return sum / N;
+	}
+
+	// whether a prediction with output magnitude 'magnitude' trains under
+	// threshold i; 'wrong' says whether the prediction counts as wrong for
+	// this threshold, which for a whole predictor is 'mispredicted'
+	bool train(int i, bool mispredicted, int magnitude, bool wrong)
+	{
+		bool low = magnitude <= theta[i];
+		if (ADAPTIVE)
+		{
+			if (wrong)
+				step(i, 1);
+			else if (low && !mispredicted)
+				step(i, -1);
+		}
+		if (mispredicted)
+			mispredicted_trainings++;
+		else if (low)
+			low_trainings++;
+		return mispredicted || low;
+	}
+
+	void report(FILE *f, long long predictions) const
+	{
+		if (predictions == 0)
+			return;
+		fprintf(f, "  trainings per prediction        %0.4f (mispredicted %0.4f, low output %0.4f)\n",
+			(mispredicted_trainings + low_trainings) / (double)(predictions * N),
+			mispredicted_trainings / (double)(predictions * N), low_trainings / (double)(predictions * N));
+		if (!ADAPTIVE)
+			fprintf(f, "  threshold                       %d (fixed)\n", theta[0]);
+		else if (N == 1)
+			fprintf(f, "  threshold                       %d (adaptive)\n", theta[0]);
+		else
+		{
+			fprintf(f, "  thresholds (adaptive)          ");
+			for (int i = 0; i < N; i++)
+				fprintf(f, " %d", theta[i]);
+			fprintf(f, "\n");
+		}
+	}
+
+  private:
+	int theta[N];
+	int tc[N];
+
+	void step(int i, int d)
+	{
+		tc[i] += d;
+		if (tc[i] > TC_MAX)
+		{
+			if (theta[i] < THETA_MAX)
+				theta[i]++;
+			tc[i] = 0;
+		}
+		else if (tc[i] < TC_MIN)
+		{
+			if (theta[i] > 0)
+				theta[i]--;
+			tc[i] = 0;
+		}
+	}
+};
+
+#endif
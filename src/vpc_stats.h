@@ -0,0 +1,209 @@
+// vpc_stats.h
+// Author: Ankur Roy Chowdhury
+// Instrumentation for the VPC predictor: how many virtual PCs each indirect
+// prediction visits, and how many BTB and perceptron lookups that costs.
+// BTB lookups and their latency are counted separately for the prediction
+// loop, which sits on the fetch path, and for the walk that retrains VPC
+// after a misprediction, which does not. Prediction-time BTB lookups are also
+// counted by the BTB level that served them. Every lookup is charged the
+// latency of the level that served it; the sum over a prediction's serial
+// lookups is its BTB latency.
+// Everything is counted per trace; the per-PC breakdown is collected always
+// but only printed on demand (predict -p).
+
+#ifndef VPC_STATS_H
+#define VPC_STATS_H
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+template <int MAX_VPC_ITERS, int BTB_LEVELS = 1, int MAX_BTB_LATENCY = 1>
+class vpc_stats
+{
+  public:
+	struct counts
+	{
+		long long predictions;		// indirect predictions
+		long long mispredictions;	// wrong or missing target
+		long long filtered;		// predicted by the monomorphic filter, VPC not consulted
+		long long btb_misses;		// VPC loop ended without a target
+		long long exhausted;		// VPC loop ran all MAX_VPC_ITERS iterations without a hit
+		long long iterations;		// sum of iterations visited at prediction time
+		long long btb_lookups;		// BTB lookups at prediction time
+		long long update_btb_lookups;	// BTB lookups of the retraining walk at update time
+		long long perceptron_lookups;	// perceptron evaluations at prediction time
+		long long btb_cycles;		// BTB latency at prediction time
+		long long update_btb_cycles;	// BTB latency of the retraining walk
+	};
+
+	static constexpr int MAX_BTB_CYCLES = MAX_VPC_ITERS * MAX_BTB_LATENCY;
+
+	counts total;
+	long long iter_hist[MAX_VPC_ITERS];			 // predictions by the iteration the loop stopped at
+	long long iter_correct[MAX_VPC_ITERS];			 // correct predictions by that iteration
+	long long btb_lookup_hist[MAX_VPC_ITERS + 1];		 // predictions by prediction-time BTB lookups spent
+	long long update_btb_lookup_hist[MAX_VPC_ITERS + 1];	 // predictions by update-time BTB lookups spent
+	long long perceptron_lookup_hist[MAX_VPC_ITERS + 1];	 // predictions by perceptron lookups spent
+	long long btb_cycle_hist[MAX_BTB_CYCLES + 1];		 // predictions by prediction-time BTB latency
+	long long update_btb_cycle_hist[MAX_BTB_CYCLES + 1];	 // predictions by update-time BTB latency
+	long long level_lookups[BTB_LEVELS + 1];		 // prediction-time BTB lookups by level served; the last counts misses
+	std::unordered_map<unsigned int, counts> per_pc;
+
+	vpc_stats(void)
+	{
+		memset(&total, 0, sizeof(total));
+		memset(iter_hist, 0, sizeof(iter_hist));
+		memset(iter_correct, 0, sizeof(iter_correct));
+		memset(btb_lookup_hist, 0, sizeof(btb_lookup_hist));
+		memset(update_btb_lookup_hist, 0, sizeof(update_btb_lookup_hist));
+		memset(perceptron_lookup_hist, 0, sizeof(perceptron_lookup_hist));
+		memset(btb_cycle_hist, 0, sizeof(btb_cycle_hist));
+		memset(update_btb_cycle_hist, 0, sizeof(update_btb_cycle_hist));
+		memset(level_lookups, 0, sizeof(level_lookups));
+	}
+
+	// count one prediction-time BTB lookup served by 'level' (-1: a miss)
+	void record_lookup(int level)
+	{
+		level_lookups[level < 0 ? BTB_LEVELS : level]++;
+	}
+
+	// record one resolved indirect prediction; the prediction loop made one
+	// BTB lookup per iteration it visited and spent 'btb_cycles' on them, the
+	// update walk 'update_lookups' lookups and 'update_cycles' cycles
+	void record(unsigned int pc, int predicted_iter, bool btb_miss, bool correct, int btb_cycles, int update_lookups,
+		    int update_cycles)
+	{
+		int lookups = predicted_iter + 1;
+		bool exhausted = btb_miss && predicted_iter == MAX_VPC_ITERS - 1;
+
+		iter_hist[predicted_iter]++;
+		iter_correct[predicted_iter] += correct;
+		btb_lookup_hist[lookups]++;
+		update_btb_lookup_hist[std::min(update_lookups, MAX_VPC_ITERS)]++;
+		perceptron_lookup_hist[lookups]++;
+		btb_cycle_hist[std::min(btb_cycles, MAX_BTB_CYCLES)]++;
+		update_btb_cycle_hist[std::min(update_cycles, MAX_BTB_CYCLES)]++;
+
+		add(total, predicted_iter, btb_miss, exhausted, correct, btb_cycles, update_lookups, update_cycles);
+		add(per_pc[pc], predicted_iter, btb_miss, exhausted, correct, btb_cycles, update_lookups, update_cycles);
+	}
+
+	// record one indirect prediction served by the monomorphic filter
+	void record_filtered(unsigned int pc, bool correct)
+	{
+		btb_lookup_hist[0]++;
+		update_btb_lookup_hist[0]++;
+		perceptron_lookup_hist[0]++;
+		btb_cycle_hist[0]++;
+		update_btb_cycle_hist[0]++;
+
+		add_filtered(total, correct);
+		add_filtered(per_pc[pc], correct);
+	}
+
+	void print(FILE *f, bool print_per_pc)
+	{
+		long long n = total.predictions;
+		fprintf(f, "VPC iteration statistics\n");
+		fprintf(f, "  indirect predictions            %lld\n", n);
+		if (n == 0)
+			return;
+		fprintf(f, "  monomorphic filter fraction     %0.4f\n", total.filtered / (double)n);
+		fprintf(f, "  BTB-miss fraction               %0.4f\n", total.btb_misses / (double)n);
+		fprintf(f, "  MAX_VPC_ITERS exhausted         %0.4f\n", total.exhausted / (double)n);
+		fprintf(f, "  BTB lookups per prediction      avg %0.3f, P99 %d\n", total.btb_lookups / (double)n,
+			percentile(btb_lookup_hist, MAX_VPC_ITERS + 1, 0.99));
+		fprintf(f, "  BTB lookups per update walk     avg %0.3f, P99 %d\n", total.update_btb_lookups / (double)n,
+			percentile(update_btb_lookup_hist, MAX_VPC_ITERS + 1, 0.99));
+		fprintf(f, "  perceptron lookups per pred.    avg %0.3f, P99 %d\n", total.perceptron_lookups / (double)n,
+			percentile(perceptron_lookup_hist, MAX_VPC_ITERS + 1, 0.99));
+		fprintf(f, "  BTB cycles per prediction       avg %0.3f, P99 %d\n", total.btb_cycles / (double)n,
+			percentile(btb_cycle_hist, MAX_BTB_CYCLES + 1, 0.99));
+		fprintf(f, "  BTB cycles per update walk      avg %0.3f, P99 %d\n", total.update_btb_cycles / (double)n,
+			percentile(update_btb_cycle_hist, MAX_BTB_CYCLES + 1, 0.99));
+
+		long long lookups = 0;
+		for (int l = 0; l <= BTB_LEVELS; l++)
+			lookups += level_lookups[l];
+		if (lookups)
+		{
+			fprintf(f, "  prediction BTB lookups served  ");
+			for (int l = 0; l < BTB_LEVELS; l++)
+				fprintf(f, " L%d %0.4f,", l + 1, level_lookups[l] / (double)lookups);
+			fprintf(f, " miss %0.4f\n", level_lookups[BTB_LEVELS] / (double)lookups);
+		}
+
+		fprintf(f, "  %4s %12s %8s %8s %12s\n", "iter", "predictions", "%", "cum %", "correct");
+		long long cumulative = 0;
+		for (int i = 0; i < MAX_VPC_ITERS; i++)
+		{
+			cumulative += iter_hist[i];
+			fprintf(f, "  %4d %12lld %8.3f %8.3f %12lld\n", i, iter_hist[i], 100.0 * iter_hist[i] / n,
+				100.0 * cumulative / n, iter_correct[i]);
+		}
+
+		if (!print_per_pc)
+			return;
+
+		// busiest indirect branches first
+		std::vector<std::pair<long long, unsigned int> > pcs;
+		for (typename std::unordered_map<unsigned int, counts>::iterator i = per_pc.begin(); i != per_pc.end(); ++i)
+			pcs.push_back(std::make_pair(-i->second.predictions, i->first));
+		std::sort(pcs.begin(), pcs.end());
+
+		fprintf(f, "  %10s %12s %12s %9s %9s %9s %9s %9s %9s %9s\n", "pc", "predictions", "mispredicts", "filtered",
+			"avg iter", "btb miss", "exhausted", "btb lkps", "btb cyc", "upd lkps");
+		for (size_t i = 0; i < pcs.size(); i++)
+		{
+			const counts &c = per_pc[pcs[i].second];
+			double p = c.predictions;
+			fprintf(f, "  0x%08x %12lld %12lld %9.4f %9.3f %9.4f %9.4f %9.3f %9.3f %9.3f\n", pcs[i].second,
+				c.predictions, c.mispredictions, c.filtered / p, c.iterations / p, c.btb_misses / p,
+				c.exhausted / p, c.btb_lookups / p, c.btb_cycles / p, c.update_btb_lookups / p);
+		}
+	}
+
+  private:
+	static void add(counts &c, int predicted_iter, bool btb_miss, bool exhausted, bool correct, int btb_cycles,
+			int update_lookups, int update_cycles)
+	{
+		c.predictions++;
+		c.mispredictions += !correct;
+		c.btb_misses += btb_miss;
+		c.exhausted += exhausted;
+		c.iterations += predicted_iter + 1;
+		c.btb_lookups += predicted_iter + 1;
+		c.update_btb_lookups += update_lookups;
+		c.perceptron_lookups += predicted_iter + 1;
+		c.btb_cycles += btb_cycles;
+		c.update_btb_cycles += update_cycles;
+	}
+
+	static void add_filtered(counts &c, bool correct)
+	{
+		c.predictions++;
+		c.mispredictions += !correct;
+		c.filtered++;
+	}
+
+	// smallest value v such that at least q of the histogram lies at or below v
+	static int percentile(const long long *hist, int n, double q)
+	{
+		long long total = 0, seen = 0;
+		for (int i = 0; i < n; i++)
+			total += hist[i];
+		for (int i = 0; i < n; i++)
+		{
+			seen += hist[i];
+			if (seen >= q * total)
+				return i;
+		}
+		return n - 1;
+	}
+};
+
+#endif